@@ -19,27 +19,12 @@ my @meshes
 my @ref_levels = (0, 1, 2, 3);
 my @finElements = ("linear", "h1:1", "h1:2", "h1:3");
 
-# Disable automatic generation of html output since we need to generate structure files for each sub-run of ex1
-# so that their information can be merged
-$ENV{SIGHT_FILE_OUT} = 1;
-foreach my $mesh (@meshes) {
-foreach my $ref_level (@ref_levels) {
-foreach my $finElement (@finElements) {
-foreach my $exactSoln (0, 1) {
-#  chdir $exDir;
-  sys("$exDir/ex1 $exDir/../data/${mesh}.mesh $ref_level $finElement $exactSoln", $verbose);
-} } } }
-
-#chdir $workDir;
-
-# Merge the output of the individual runs
-sys("../hier_merge dbg.MFEM.ex1 zipper dbg.MFEM.ex1.meshFile_*.ref_levels_*/structure", $verbose);
-
-# Visualize the merged data
-sys("../slayout dbg.MFEM.ex1/structure", $verbose);
-
-# Remove the directories of the individual runs
-sys("rm -fr dbg.MFEM.ex1.*");
+# Run all the combinations of the parameters concurrently and merge their structure files as they complete.
+# The outputs of the individual runs are cached in sweepCache and reused if ex1 and its arguments have not changed.
+sys("../sight_sweep -out dbg.MFEM.ex1 -merge zipper -cache sweepCache -layout ".
+    "-p mesh=".join(",", @meshes)." -p ref_level=".join(",", @ref_levels)." -p finElement=".join(",", @finElements)." -p exactSoln=0,1 ".
+    "-- $exDir/ex1 $exDir/../data/{mesh}.mesh {ref_level} {finElement} {exactSoln}", $verbose);
+
 
 sub sys {
   my ($cmd, $verbose) = @_;
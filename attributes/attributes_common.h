@@ -571,6 +571,12 @@ extern baseAttrValueComparatorInstantiator baseAttrValueComparatorInstance;
 // not deallocate the array until they've deallocated any sightArrays that refer to it. Callers also have the option
 // of making the sightArray the owner of the array, meaning that it will deallocate the array using delete when
 // it is deallocated.
+// Once a snapshot directory has been set, large numeric arrays are not serialized inline. Instead, serialize() 
+// copies the array into a pooled buffer and emits a reference to a payload file named after the hash of the 
+// array's contents, which a background thread writes into the snapshot directory. Arrays whose contents were 
+// already written become back-references to the existing payload and, if enabled, arrays are delta-encoded 
+// relative to the previous snapshot of the same source buffer. References are relative to the log's working 
+// directory.
 class sightArray : public customAttrValue {
   public:
   // Definition for specifying the dimensionality of arrays.
@@ -627,6 +633,52 @@ class sightArray : public customAttrValue {
   
   // Compares this object to that one using the given comparator and returns their relation to each other
   attrValue compare(const customAttrValue& that, comparator& comp) const;
+  
+  // --- Snapshots ---
+  
+  // The directory into which snapshot payloads are written. If empty, all arrays are serialized inline.
+  static std::string snapshotDir;
+  
+  // The sub-directory of the log's working directory that holds the snapshot payloads
+  static std::string snapshotSubDir;
+  
+  // The working directory of the log being read, relative to which the references to snapshot payloads are resolved
+  static std::string snapshotBaseDir;
+  
+  // Arrays with fewer elements than this are serialized inline (SIGHT_ARRAY_SNAPSHOT_MIN, default 1024)
+  static long snapshotMinElements;
+  
+  // If >0, snapshots are delta-encoded relative to the previous snapshot of the same source buffer and
+  // a full snapshot is written after every deltaInterval deltas (SIGHT_ARRAY_DELTA, default 0)
+  static int deltaInterval;
+  
+  // Enables snapshots, writing their payloads into the given directory
+  static void setSnapshotDir(const std::string& dir);
+  
+  // Waits until the payloads of all the snapshots taken so far have been written
+  static void flushSnapshots();
+  
+  // Links the snapshot payloads of the logs in the given working directories into the snapshot sub-directory of
+  // the working directory of the log they're being merged into, so that the references to them remain valid
+  static void mergeSnapshots(const std::vector<std::string>& inWorkDirs, const std::string& outWorkDir);
+  
+  protected:
+  // Returns whether this array is serialized as a snapshot rather than inline
+  bool isSnapshot() const;
+  
+  // Adds the text representation of the given elements of an array of the given type to the given output stream
+  static void serializeVals(std::ostream& s, const void* array, attrValue::valueType type, long numElements);
+  
+  // Body of the thread that writes snapshot payloads
+  static void* snapshotWriter(void* arg);
+  
+  // Returns whether the payload with the given name holds the contents of the given array, which holds numElements
+  // elements of the given type. Must be called while holding the lock that protects the snapshot state.
+  static bool snapshotMatches(const std::string& name, const void* array, attrValue::valueType type, long numElements);
+  
+  // Reads the payload with the given name from the given snapshot directory into array, which holds numElements 
+  // elements of the given type
+  static void loadSnapshot(const std::string& dir, const std::string& name, void* array, attrValue::valueType type, long numElements);
 }; // class sightArray
 
 // Registers deserialization functions for each custom attrValue type we've defined here
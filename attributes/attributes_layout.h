@@ -32,10 +32,50 @@ class attributesC : public common::attributesC
   
   // Returns a representation of the attributes database as a JavaScript map
   std::string strJS() const;
+  
+  // Returns the representation of the given attribute value used in JavaScript
+  static std::string valStrJS(const attrValue& v);
+  
+  friend class attributeIndex;
 };
 
 extern layout::attributesC attributes;
 
+// ***************************
+// ***** Attribute Index *****
+// ***************************
+
+// Filtering the blocks of large logs by their attributes is too slow if the viewer must load the attributes
+// of every block and scan them. Instead, slayout indexes the attributes of all the blocks as they are laid out
+// and writes the index into the attrIndex widget directory when the log is complete:
+// - blocks: the IDs of all the blocks, one per line. A block's position in this list is its ordinal.
+// - postings: for each key and each of its values, the sorted ordinals of the blocks where the key has that
+//   value, as consecutive Int32 arrays in the host's byte order.
+// - index.json: for each key, whether its values are all numeric, the sorted list of its distinct values
+//   and the offset and number of entries of each value's array in postings.
+// The viewer loads these files when the user first filters by attribute and answers queries by intersecting
+// the arrays of the requested values.
+class attributeIndex
+{
+  // The IDs of all the blocks, in the order in which they were laid out
+  std::vector<std::string> blockIDs;
+  
+  // Maps each key to each of its values and the ordinals of the blocks where the key has that value
+  std::map<std::string, std::map<std::string, std::vector<int> > > postings;
+  
+  // Records the keys that have at least one non-numeric value
+  std::set<std::string> nonNumeric;
+  
+  public:
+  // Adds the block with the given ID, which has the given attributes
+  void add(const std::string& blockID, const attributesC& attrs);
+  
+  // Writes the index into the given directory (absolute path, path relative to the html directory)
+  void write(const std::pair<std::string, std::string>& dirs);
+};
+
+extern layout::attributeIndex attrIndex;
+
 // *******************************
 // ***** Attribute Interface *****
 // *******************************
@@ -622,6 +622,17 @@ void* attrFalse_enter();
 void attrFalse_exit(void* subQ);
 }
 
+// Enables the snapshotting of large sightArrays once the log's working directory is known
+class AttributeSightInitHandlerInstantiator: public SightInitHandlerInstantiator {
+  public:
+  AttributeSightInitHandlerInstantiator();
+  
+  // Directs sightArray snapshots into the arrays sub-directory of the working directory 
+  // if they're enabled by setting SIGHT_ARRAY_SNAPSHOTS=1
+  static void initArraySnapshots();
+};
+extern AttributeSightInitHandlerInstantiator AttributeSightInitHandlerInstance;
+
 class AttributeMergeHandlerInstantiator: public MergeHandlerInstantiator {
   public:
   AttributeMergeHandlerInstantiator();
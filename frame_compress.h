@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <streambuf>
+#include <stdio.h>
+
+namespace sight {
+
+/* #################### DESIGN NOTES ####################
+Structure files compress very well but are normally written as plain text. When SIGHT_COMPRESS is set,
+dbgStream writes its structure file through a frameCompressBuf, which splits it into frames that are
+compressed independently with zlib, so that readers can decompress any frame without the ones before it.
+Each frame ends at the end of a tag, so parsing can start at the beginning of any frame. The file is laid
+out as follows, with all integers stored in the writer's native byte order:
+  FRAME_MAGIC                                  8 bytes that identify compressed structure files
+  for each frame:
+    rawLen, compLen                            uint32 uncompressed and compressed sizes of the frame
+    compLen bytes of zlib data
+  0, indexLen                                  a header with rawLen 0 marks the end of the frames
+  for each frame:
+    fileOffset, rawOffset                      uint64 offsets of the frame's header in the file and of its
+                                               first byte in the uncompressed structure
+  indexOffset, numFrames, FRAME_INDEX_MAGIC    uint64, uint64, 8 bytes: the trailer that locates the index
+Readers that stream through the file stop at the end marker. Readers that seek use the index, which
+they rebuild by walking the frame headers if the writer did not live to write it.
+
+The uncompressed offsets of tags, as reported by structureParser::offset(), are the same as if the
+file were not compressed.
+############################################################ */
+
+// Stream buffer that compresses the structure written through it into frames and writes them to baseBuf
+class frameCompressBuf : public std::streambuf {
+  std::streambuf* baseBuf;
+
+  // Frames are cut at the end of the first tag that ends after frameSize uncompressed bytes
+  size_t frameSize;
+  // The zlib compression level
+  int level;
+
+  // The uncompressed text of the current frame
+  std::string raw;
+  // Buffer that holds each compressed frame
+  std::vector<char> comp;
+
+  // The offsets in the file and in the uncompressed structure of the start of each frame
+  std::vector<unsigned long long> fileOffsets;
+  std::vector<unsigned long long> rawOffsets;
+
+  // The number of bytes written to and read from the file so far
+  unsigned long long fileBytes;
+  unsigned long long rawBytes;
+
+  bool closed;
+
+  public:
+  frameCompressBuf(std::streambuf* baseBuf, size_t frameSize=1<<20, int level=6);
+  ~frameCompressBuf();
+
+  // Writes out the last frame and the frame index. No more data may be written afterwards.
+  void close();
+
+  // Returns a summary of the compression achieved so far
+  std::string str() const;
+
+  protected:
+  virtual int_type overflow(int_type c);
+  virtual std::streamsize xsputn(const char* s, std::streamsize num);
+  // Syncing does not cut a frame, since applications sync after every line of text
+  virtual int sync();
+
+  // Compresses the first len bytes of raw into a frame and writes it out
+  void writeFrame(size_t len);
+
+  // Writes the given bytes to baseBuf
+  void put(const void* data, size_t len);
+}; // class frameCompressBuf
+
+// Reads the uncompressed structure from a file written by frameCompressBuf
+class frameReader {
+  FILE* f;
+
+  // The uncompressed text of the current frame, the position of the next byte to be read from it and
+  // the offset of its start in the uncompressed structure
+  std::vector<char> frame;
+  size_t framePos;
+  unsigned long long frameRawOffset;
+  // Buffer that holds the compressed frame
+  std::vector<char> comp;
+
+  // Records whether we've read the last frame and whether we've encountered an error
+  bool ended;
+  bool failed;
+
+  // The offsets in the file and in the uncompressed structure of the start of each frame, loaded when first needed
+  bool indexLoaded;
+  std::vector<unsigned long long> fileOffsets;
+  std::vector<unsigned long long> rawOffsets;
+
+  public:
+  // Reads from the given file, the magic bytes at the start of which have already been read
+  frameReader(FILE* f);
+
+  // Reads the magic bytes at the start of the given file, returning whether it is a compressed structure
+  // file. If it is not, sets prefix to the bytes that were read.
+  static bool readMagic(FILE* f, std::string& prefix);
+
+  // Reads up to len bytes of the uncompressed structure into buf. Returns the number of bytes read, which
+  // is 0 only at the end of the structure or on error.
+  size_t read(char* buf, size_t len);
+
+  bool end() const { return ended; }
+  bool error() const { return failed; }
+
+  // Returns the number of frames in the file and the offset in the uncompressed structure of the given frame's
+  // start, loading the index if needed. The file must be seekable.
+  int numFrames();
+  unsigned long long frameOffset(int frame);
+
+  // Positions the reader at the given offset in the uncompressed structure. Returns whether this succeeded,
+  // which requires the file to be seekable.
+  bool seek(unsigned long long rawOffset);
+
+  protected:
+  // Reads the frame at the current file position. Returns false at the end marker or on error.
+  bool readFrame();
+
+  // Loads the index from the file's trailer, or rebuilds it from the frame headers if there is none
+  bool loadIndex();
+}; // class frameReader
+
+} // namespace sight
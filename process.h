@@ -9,10 +9,15 @@
 #include <string.h>
 #include <errno.h>
 #include "sight_common_internal.h"
+#include "shm_ring.h"
+#include "tag_loops.h"
+#include "frame_compress.h"
 //#include "sight_layout.h"
 
 namespace sight {
 
+class structureIndex;
+
 template<typename streamT>
 class baseStructureParser : public common::structureParser {
   protected:
@@ -28,6 +33,27 @@ class baseStructureParser : public common::structureParser {
   // The current index of the read pointer within buf[]
   int bufIdx;
   
+  // The offset within the data source of buf[0]
+  long long bufOffset;
+  
+  // The number of bytes at the start of buf that were spliced in by expanding a loop iteration rather than
+  // read from the data source, and the offset within the data source of the loop tag they were expanded from
+  size_t injectedLen;
+  long long injectedAt;
+  
+  // Expands the loop tags in the input
+  loopExpander loops;
+  
+  // When parsing only the subtree of one tag, the entries of the tags that enclose it, which are returned
+  // before it, and their exits, which are returned after it
+  std::list<properties> enclosingEntries;
+  std::list<properties> enclosingExits;
+  // Records whether we're parsing only the subtree of one tag, the number of its tags that are currently
+  // open and whether we've read its exit
+  bool inSubtree;
+  int subtreeDepth;
+  bool subtreeDone;
+  
   // Reference to the data source
   streamT* stream;
   
@@ -67,7 +93,25 @@ class baseStructureParser : public common::structureParser {
   // the object it denotes.
   std::pair<properties::tagType, const properties*> next();
   
+  // Returns the number of bytes of the data source that have been consumed by the tags returned so far.
+  // Tags expanded from a loop iteration are all reported to end at the end of its loop tag.
+  long long offset() const { return (size_t)bufIdx < injectedLen? injectedAt: bufOffset + bufIdx; }
+  
+  // Returns the offset of the start of the next tag or text that next() will return. After a tag has been
+  // returned the read pointer may still be on its closing bracket, which text never contains.
+  long long nextOffset() const 
+  { return offset() + ((loc==enterTagRead || loc==exitTagRead) && (size_t)bufIdx<dataInBuf && buf[bufIdx]==']'? 1: 0); }
+  
+  // Returns whether the next tag may be read from the middle of the expansion of a loop iteration,
+  // in which case parsing cannot be resumed at its offset
+  bool expanding() const { return (size_t)bufIdx < injectedLen; }
+  
+  const loopExpander& getLoops() const { return loops; }
+  
   protected:
+  // Reads the next tag from the data source
+  std::pair<properties::tagType, const properties*> nextTag();
+  
   // Read a property name/value pair from the given file, setting name and val to them.
   // Reading starts at buf[bufIdx] and continues as far as needed, reading more file 
   // contents into buf if the end of buf is reached. bufSize is the number of bytes in 
@@ -103,6 +147,13 @@ class baseStructureParser : public common::structureParser {
   // Otherwise, returns false.
   bool nextChar();
   
+  // Replaces the loop tag that ends at buf[bufIdx] with the given text, which is read next
+  void splice(const std::string& expansion);
+  
+  // Called after the data source has been repositioned to the given offset, which must be the start of a tag,
+  // to resume parsing from there
+  void restart(long long offset);
+  
   // Returns true if character c is in array termChars of size numTermChars and 
   // false otherwise.
   static bool isMember(char c, const char* termChars, int numTermChars);
@@ -114,12 +165,38 @@ class FILEStructureParser : public baseStructureParser<FILE> {
   // or was given a ready FILE* stream
   bool openedFile;
   
+  // Reads the structure if the file was written in compressed frames (SIGHT_COMPRESS), or NULL if it is plain text
+  frameReader* frames;
+  // The bytes read from the start of a plain text file while checking whether it is compressed, which 
+  // are returned before the rest of the file
+  std::string prefix;
+  
   public:
   FILEStructureParser(std::string fName, int bufSize=10000);
   FILEStructureParser(FILE* f, int bufSize=10000);
   ~FILEStructureParser();
   
   protected:
+  // Checks whether the file is compressed
+  void initFrames();
+  
+  public:
+  // Returns the reader of the file's compressed frames, or NULL if the file is not compressed
+  frameReader* getFrames() const { return frames; }
+  
+  // Resumes parsing at the given offset of the uncompressed structure, which must be the start of a tag, 
+  // such as the start of a compressed frame. Returns whether this succeeded, which requires the file to be seekable.
+  bool seek(long long offset);
+  
+  // Restricts parsing to the subtree of the tag of the given record of the given index of this file. next() 
+  // returns the entries of the tags that enclose it, its own tags and then the exits of the enclosing tags.
+  // Returns whether this succeeded, which requires the file to be seekable.
+  bool resume(const structureIndex& index, int rec);
+  
+  protected:
+  // Resumes parsing at the tag of the given record, returning its entry or NULL properties on failure
+  std::pair<properties::tagType, const properties*> resumeAt(const structureIndex& index, int rec);
+  
   // Functions implemented by children of this class that specialize it to take input from various sources.
   
   // readData() reads as much data as is available from the data source into buf[], upto bufSize bytes 
@@ -133,4 +210,102 @@ class FILEStructureParser : public baseStructureParser<FILE> {
   bool streamError();
 };
 
+// Parses the structure that another process on the same node streams through a shared-memory ring
+class shmRingStructureParser : public baseStructureParser<shmRing> {
+  std::string ringName;
+  // Records whether the writer has closed the ring and we've read all of its data
+  bool ended;
+  
+  public:
+  // Attaches to the ring with the given name, waiting up to timeoutSec seconds for its writer to create it
+  shmRingStructureParser(std::string ringName, int timeoutSec=600, int bufSize=10000);
+  ~shmRingStructureParser();
+  
+  protected:
+  // Functions implemented by children of this class that specialize it to take input from various sources.
+  
+  // readData() reads as much data as is available from the data source into buf[], upto bufSize bytes 
+  // and returns the amount of data actually read.
+  size_t readData();
+  
+  // Returns true if we've reached the end of the input stream
+  bool streamEnd();
+  
+  // Returns true if we've encountered an error in input stream
+  bool streamError();
+};
+
+// Sidecar index of a structure file, written by sindex, which lets tools parse the subtree of a single tag
+// without reading the file from its start. The index holds a record for each block, each trace stream and 
+// each file-level (high) scope, as well as for the tags that enclose them. Each record holds the offset in
+// the uncompressed structure from which the tag can be reached and the record of the tag that encloses it, 
+// from which parsing can be resumed with the correct stack of enclosing tags. Tags that were expanded from
+// the middle of a loop iteration are reached by resuming at the loop tag and skipping the tags before them
+// in the iteration. The index also holds the loop templates of the file, since the subtree of a tag may 
+// refer to templates defined before it. The index is a text file of tab-separated lines:
+//   template ID segment0 segment1 ...
+//   record name offset skip endOffset parent blockID anchorID traceID fileLevel
+// where missing keys are written as "-" and fields are escaped to contain no tabs or newlines.
+class structureIndex {
+  public:
+  class record {
+    public:
+    // The name of the tag
+    std::string name;
+    // The offset at which parsing must resume to reach the tag's entry, the number of tags and text 
+    // records that must then be skipped, and the offset of the end of the tag's exit
+    long long offset;
+    long skip;
+    long long endOffset;
+    // The index of the record of the innermost tag that encloses this one, or -1 if there is none
+    int parent;
+    // The keys of the tag, which are empty if it has none
+    std::string blockID;
+    std::string anchorID;
+    std::string traceID;
+    // The index of the tag among all the file-level scopes, or -1 if it is not one
+    int fileLevel;
+    
+    record() : offset(-1), skip(0), endOffset(-1), parent(-1), fileLevel(-1) {}
+  };
+  
+  std::vector<record> records;
+  
+  // The literal segments of the file's loop templates
+  std::map<int, std::vector<std::string> > templates;
+  
+  protected:
+  // Map each key to its record
+  std::map<std::string, int> blocks;
+  std::map<std::string, int> anchors;
+  std::map<std::string, int> traces;
+  std::vector<int> fileLevels;
+  
+  public:
+  structureIndex() {}
+  
+  // Loads the index from the given file
+  structureIndex(std::string fName);
+  
+  // Returns the name of the index of the given structure file
+  static std::string indexFName(std::string structFName) { return structFName+".idx"; }
+  
+  // Builds the index by reading the entire structure from the given parser
+  void build(FILEStructureParser& parser);
+  
+  // Writes the index to the given file
+  void write(std::string fName) const;
+  
+  // Returns the record of the tag with the given key, where kind is block, anchor, trace or file, or -1 if 
+  // there is none
+  int find(std::string kind, std::string key) const;
+  
+  // Returns the number of tags enclosing the given record
+  int depth(int rec) const;
+  
+  protected:
+  // Adds the record of the given key to the given map
+  void addKey(std::map<std::string, int>& keys, const std::string& key, int rec);
+}; // class structureIndex
+
 } // namespace sight
@@ -47,6 +47,9 @@ var attrKey2AllVals = {};
 function recordAttr(record, divID) {
   //console.log("record="+JSON.stringify(record));
   
+  // Once slayout has indexed the attributes of all the blocks, there is no need to record them here
+  if(attrIndexDir !== undefined) return;
+  
   if(attributes === undefined)
     attributes = TAFFY( [] );
   
@@ -65,10 +68,151 @@ function recordAttr(record, divID) {
   //alert("attrKey2AllVals="+JSON.stringify(attrKey2AllVals));
 }
 
+/********************************
+ ***** The Attributes Index *****
+ ********************************/
+
+// The directory that holds the index of the attributes of all the blocks in the log, if slayout created one
+var attrIndexDir;
+
+// The attributes index, once it has been loaded:
+// {blocks:[blockID, ...], 
+//  postings:Int32Array, 
+//  keys:{keyName:{numeric:, vals:[sorted values], offsets:[...], counts:[...], valIdx:{value:index in vals}}}}
+// The blocks where key keyName has value vals[i] are identified by their indexes in blocks, which are 
+// stored in sorted order in postings[offsets[i]] ... postings[offsets[i]+counts[i]-1].
+var attrIndex;
+
+// Records that the attributes of the log's blocks are indexed in the given directory. This is called from the 
+// epilog of the log's root file, which slayout only writes once the index is complete, so until then the 
+// attributes of the loaded blocks are recorded by recordAttr(). The index supersedes these records.
+function useAttrIndex(dir) {
+  attrIndexDir = dir;
+  attributes = undefined;
+  attrKey2AllVals = {};
+}
+
+// Loads the attributes index and calls continuationFunc() once it is available
+function loadAttrIndex(continuationFunc) {
+  if(attrIndex !== undefined) { continuationFunc(); return; }
+  
+  // The index's files are fetched concurrently
+  var texts, postings;
+  var pending = 2;
+  var ready = function() {
+    if(--pending > 0) return;
+    if(texts[0] == null || texts[1] == null || postings == null) { alert("ERROR: cannot load the attributes index from "+attrIndexDir+"!"); return; }
+    
+    var index = JSON.parse(texts[0]);
+    for(keyName in index.keys) { if(index.keys.hasOwnProperty(keyName)) {
+      var key = index.keys[keyName];
+      key.valIdx = {};
+      for(var i=0; i<key.vals.length; i++) key.valIdx[key.vals[i]] = i;
+    } }
+    
+    var blocks = texts[1].split("\n");
+    blocks.length = index.numBlocks;
+    attrIndex = {blocks: blocks, postings: new Int32Array(postings), keys: index.keys};
+    continuationFunc();
+  };
+  loadFiles([attrIndexDir+"/index.json", attrIndexDir+"/blocks"], function(t) { texts = t; ready(); });
+  loadBinaryFile(attrIndexDir+"/postings", function(buf) { postings = buf; ready(); });
+}
+
+// Returns the sorted indexes of the blocks where key has the i-th of its values
+function attrIndexPostings(key, i) {
+  return attrIndex.postings.subarray(key.offsets[i], key.offsets[i]+key.counts[i]);
+}
+
+// Returns the sorted array of the elements that are in both of the given sorted arrays
+function intersectSorted(a, b) {
+  var out = [];
+  for(var i=0, j=0; i<a.length && j<b.length; ) {
+    if(a[i] < b[j])      i++;
+    else if(a[i] > b[j]) j++;
+    else { out.push(a[i]); i++; j++; }
+  }
+  return out;
+}
+
+// Returns the sorted array of the indexes of all the blocks that are not in the given sorted array
+function complementSorted(a) {
+  var out = [];
+  for(var b=0, i=0; b<attrIndex.blocks.length; b++) {
+    if(i<a.length && a[i]==b) i++;
+    else out.push(b);
+  }
+  return out;
+}
+
+// Returns the sorted indexes of the blocks where the value of the given key satisfies the given condition,
+// which has the same format as TAFFY conditions: {op:value}, where op is ==, !=, <, <=, > or >=.
+// Blocks that do not have the key only satisfy != conditions.
+function attrIndexMatches(keyName, cond) {
+  var key = attrIndex.keys[keyName];
+  var op = Object.keys(cond)[0];
+  var val = cond[op];
+  
+  if(op == "==" || op == "!=") {
+    var eq = (key !== undefined && key.valIdx.hasOwnProperty(val)? attrIndexPostings(key, key.valIdx[val]): []);
+    return (op == "=="? eq: complementSorted(eq));
+  }
+  
+  if(key === undefined) return [];
+  // Find the range of the key's sorted values that satisfy the condition via binary search
+  var less = function(a, b) { return key.numeric? parseFloat(a) < parseFloat(b): a < b; };
+  var lowerBound = function(strict) {
+    // Returns the index of the first value that is >= val (strict=false) or > val (strict=true)
+    var lo=0, hi=key.vals.length;
+    while(lo < hi) {
+      var mid = (lo+hi) >> 1;
+      if(strict? !less(val, key.vals[mid]): less(key.vals[mid], val)) lo = mid+1;
+      else hi = mid;
+    }
+    return lo;
+  };
+  var begin=0, end=key.vals.length;
+  if(op == "<")       end   = lowerBound(false);
+  else if(op == "<=") end   = lowerBound(true);
+  else if(op == ">")  begin = lowerBound(true);
+  else if(op == ">=") begin = lowerBound(false);
+  else { alert("ERROR: unknown attribute query operator "+op+"!"); return []; }
+  
+  // Merge the blocks of all the values in the range
+  var out = [];
+  for(var i=begin; i<end; i++) {
+    var p = attrIndexPostings(key, i);
+    for(var j=0; j<p.length; j++) out.push(p[j]);
+  }
+  out.sort(function(a, b) { return a-b; });
+  return out;
+}
+
+// Returns the IDs of the blocks that satisfy all the conditions in the given query, which maps key names 
+// to conditions
+function attrIndexQuery(query) {
+  var matches;
+  for(keyName in query) { if(query.hasOwnProperty(keyName)) {
+    var keyMatches = attrIndexMatches(keyName, query[keyName]);
+    matches = (matches === undefined? keyMatches: intersectSorted(matches, keyMatches));
+  } }
+  if(matches === undefined) matches = complementSorted([]);
+  
+  var blockIDs = [];
+  for(var i=0; i<matches.length; i++) blockIDs.push(attrIndex.blocks[matches[i]]);
+  return blockIDs;
+}
+
 // Encodes all the queries that need to be pertformed as a map from key names to arrays of their acceptable values
 var allQueries;
 
 function writeKeyValTable(id, viewType) {
+  // If the attributes are indexed, make sure that the index is loaded
+  if(attrIndexDir !== undefined && attrIndex === undefined) {
+    loadAttrIndex(function() { writeKeyValTable(id, viewType); });
+    return;
+  }
+  
   resetKeyValTable(id);
   
   var tgtDiv = document.getElementById(id);
@@ -78,27 +222,36 @@ function writeKeyValTable(id, viewType) {
   
   var numKeys=0;
   
+  // Create an alternate representation of attrKey2AllVals that maps each key to 
+  // an array of its corresponding values, rather than a hash. If the attributes are indexed, 
+  // take the sorted values of each key from the index.
+  var attrKey2AllValsArray = {};
+  var maxValsPerKey=-1; // The maximum number of values any key is mapped to
+  if(attrIndex !== undefined) {
+    for(keyName in attrIndex.keys) { if(attrIndex.keys.hasOwnProperty(keyName)) {
+      attrKey2AllValsArray[keyName] = attrIndex.keys[keyName].vals;
+    } }
+  } else {
+    for(keyName in attrKey2AllVals) { if(attrKey2AllVals.hasOwnProperty(keyName)) {
+      attrKey2AllValsArray[keyName] = Object.keys(attrKey2AllVals[keyName]);
+    } }
+  }
+  for(keyName in attrKey2AllValsArray) { if(attrKey2AllValsArray.hasOwnProperty(keyName)) {
+    if(maxValsPerKey < attrKey2AllValsArray[keyName].length) maxValsPerKey = attrKey2AllValsArray[keyName].length;
+  } }
+  
   // Header
   str += "  <tr>";
-  for(keyName in attrKey2AllVals) { if(attrKey2AllVals.hasOwnProperty(keyName)) {
+  for(keyName in attrKey2AllValsArray) { if(attrKey2AllValsArray.hasOwnProperty(keyName)) {
     str += "<td bgcolor=\"#FCAB03\" style=\"font-size:large; font-weight:bold; text-align:center;\">"+keyName.substring(4)+"</td>";
     numKeys++;
   } }
   str += "</tr>\n";
   
-  // Create an alternate representation of attrKey2AllVals that maps each key to 
-  // an array of its corresponding values, rather than a hash.
-  var attrKey2AllValsArray = {};
-  var maxValsPerKey=-1; // The maximum number of values any key is mapped to
-  for(keyName in attrKey2AllVals) { if(attrKey2AllVals.hasOwnProperty(keyName)) {
-    attrKey2AllValsArray[keyName] = Object.keys(attrKey2AllVals[keyName]);
-    if(maxValsPerKey < attrKey2AllValsArray[keyName].length) maxValsPerKey = attrKey2AllValsArray[keyName].length;
-  } }
-  
   // Body with the values mapped to each key
   for(var i=0; i<maxValsPerKey; i++) {
     str += "  <tr>";
-    for(keyName in attrKey2AllValsArray) { if(attrKey2AllVals.hasOwnProperty(keyName)) {
+    for(keyName in attrKey2AllValsArray) { if(attrKey2AllValsArray.hasOwnProperty(keyName)) {
       str += "<td style=\"text-align:center;\">";
       if(i<attrKey2AllValsArray[keyName].length) {
         var value = attrKey2AllValsArray[keyName][i];
@@ -143,6 +296,12 @@ function attrCheckClick(checkbox) {
 
 // Performs the query and views or hides the selected blocks
 function filterByAttr(viewType) {
+  // If the index became available after the table was written, make sure that it is loaded
+  if(attrIndexDir !== undefined && attrIndex === undefined) {
+    loadAttrIndex(function() { filterByAttr(viewType); });
+    return;
+  }
+  
   // The query object that we'll incrementally build up in filterByAttr_subQuery
   query = {};
   filterByAttr_subQuery(Object.keys(allQueries), 0, query, viewType);
@@ -169,6 +328,10 @@ function filterByAttr_subQuery(keys, keyIdx, query, viewType) {
       } //}
     }
   // If we've constructed the current query
+  } else if(attrIndex !== undefined) {
+    var blockIDs = attrIndexQuery(query);
+    for(var i=0; i<blockIDs.length; i++)
+      toggleVisibility(blockIDs[i], (viewType=='add'? true: false));
   } else {
     //alert("filterByAttr("+viewType+")");
     attributes(query).each(function (match) {
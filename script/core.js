@@ -251,7 +251,9 @@ function loadURLIntoDiv(doc, url, divName, continuationFunc) {
   
 // From http://www.javascriptkit.com/javatutors/loadjavascriptcss.shtml
 //  and http://stackoverflow.com/questions/950087/how-to-include-a-javascript-file-in-another-javascript-file
-function loadjscssfile(filename, filetype, continuationFunc){
+// If ordered is true, scripts are fetched concurrently with all other scripts but run in the order in which they
+// were requested relative to other ordered scripts.
+function loadjscssfile(filename, filetype, continuationFunc, ordered){
   if (filetype=="text/css"){ //if filename is an external CSS file
     var fileref=document.createElement("link")
     fileref.setAttribute("rel", "stylesheet")
@@ -262,6 +264,7 @@ function loadjscssfile(filename, filetype, continuationFunc){
     var fileref=document.createElement('script')
     fileref.setAttribute("type", filetype)
     fileref.setAttribute("src", filename)
+    if(ordered) fileref.async = false;
   } else {
     alert("ERROR: unknown file type \""+filetype+"\" for file name \""+filename+"\"!");
     return;
@@ -288,42 +291,240 @@ function loadFile(url, continuationFunc) {
   xhr.send();
 }
 
-// Loads the given file. The file is assumed to contain the paths of scripts, one per line.
+// Loads the given binary file and calls continuationFunc() on its contents as an ArrayBuffer,
+// or on null if it could not be loaded
+function loadBinaryFile(url, continuationFunc) {
+  var xhr= new XMLHttpRequest();
+  xhr.open('GET', url, true);
+  xhr.responseType = 'arraybuffer';
+  xhr.onreadystatechange= function() {
+    if (this.readyState!==4) return;
+    // Files loaded from the local file system report status 0
+    continuationFunc((this.status==200 || this.status==0) && this.response? this.response: null);
+  };
+  xhr.send();
+}
+
+// Returns the current time in milliseconds
+function loadClock() {
+  return (window.performance && window.performance.now? window.performance.now(): new Date().getTime());
+}
+
+// Records how long each phase of loading each file took, keyed by the URL of the file's detail body. Each 
+// entry maps a phase to the number of milliseconds from the start of the load until the phase finished: 
+// {includes:, detail:, summary:, fetchScripts:, prolog:, script:, epilog:, total:}. Phases that run 
+// concurrently overlap, so the total is usually smaller than their sum.
+var loadTimings = {};
+
+// Prints the timing of each phase of loading each file to the console and returns loadTimings
+function loadTimingReport() {
+  if(console.table) console.table(loadTimings);
+  else              console.log(JSON.stringify(loadTimings));
+  return loadTimings;
+}
+
+// Fetches the given URLs concurrently and calls continuationFunc() on the array of their contents, in 
+// the same order as urls. The contents of URLs that could not be fetched or are undefined are null.
+function loadFiles(urls, continuationFunc) {
+  var texts = [];
+  var pending = urls.length;
+  if(pending == 0) { continuationFunc(texts); return; }
+  
+  for(var i=0; i<urls.length; i++) {
+    texts.push(null);
+    if(typeof urls[i] === 'undefined') { if(--pending == 0) continuationFunc(texts); continue; }
+    
+    (function(i) {
+      var xhr= new XMLHttpRequest();
+      xhr.open('GET', urls[i], true);
+      xhr.onreadystatechange= function() {
+        if (this.readyState!==4) return;
+        // Files loaded from the local file system report status 0
+        if(this.status==200 || this.status==0) texts[i] = this.responseText;
+        if(--pending == 0) continuationFunc(texts);
+      };
+      xhr.send();
+    })(i);
+  }
+}
+
+// Runs the given script text, which was fetched from url, in the global scope of this document
+function runScriptText(text, url) {
+  var scriptNode = document.createElement('script');
+  scriptNode.setAttribute("type", "text/javascript");
+  // Attribute any errors to the script's file
+  scriptNode.text = text + "\n//# sourceURL=" + url;
+  document.getElementsByTagName("head")[0].appendChild(scriptNode);
+}
+
+// Loads the given file. The file is assumed to contain the paths of scripts and stylesheets, one per line.
+// All of them are fetched concurrently and the scripts are run in the order in which they are listed.
 // After the loading is finished, calls continuationFunc()
 function loadScriptsInFile(doc, url, continuationFunc) {
   loadFile(url, function(text) {
       var lines=text.split("\n");
+      var files=[];
+      for(var i=0; i<lines.length && lines[i] != ""; i++) files.push(lines[i].split(" "));
       
-      function recursiveLoad(lines, i) {
-        if(i<lines.length && lines[i] != "") {
-          var fields = lines[i].split(" ");
-          loadjscssfile(fields[0], fields[1],
-            function() {
-              recursiveLoad(lines, i+1);
-            }
-          )
-        } else 
-          continuationFunc();
+      var pending = files.length;
+      if(pending == 0) { continuationFunc(); return; }
+      for(var i=0; i<files.length; i++) {
+        // Browsers may report the completion of a file via both onload and onreadystatechange
+        loadjscssfile(files[i][0], files[i][1],
+          (function() { 
+            var done=false;
+            return function() { if(done) return; done=true; if(--pending == 0) continuationFunc(); };
+          })(), true);
       }
-      recursiveLoad(lines, 0);
     });
 }
 
+// Runs the prolog, script and epilog of a file, given their URLs and contents, in order, recording 
+// the time at which each finished in timing relative to start
+function runFileScripts(urls, texts, timing, start) {
+  var phases = ["prolog", "script", "epilog"];
+  for(var i=0; i<phases.length; i++) {
+    if(texts[i] != null) runScriptText(texts[i], urls[i]);
+    timing[phases[i]] = loadClock() - start;
+  }
+}
+
+// Loads the top-level detail file: the scripts and stylesheets listed in includesURL, its body, which is 
+// placed in div divName, and its prolog, script and epilog. All of them are fetched concurrently. The prolog, 
+// script and epilog are run in order once the includes have run and the body has been inserted, since they 
+// refer to both.
+function loadDetailFile(doc, includesURL, detailURL, divName, scriptURL) {
+  var start = loadClock();
+  var timing = {};
+  loadTimings[detailURL] = timing;
+  
+  var scriptURLs = [scriptURL+".prolog", scriptURL, scriptURL+".epilog"];
+  var scriptTexts;
+  // The number of the includes, body and scripts that have not yet arrived
+  var pending = 3;
+  var ready = function() {
+    if(--pending > 0) return;
+    runFileScripts(scriptURLs, scriptTexts, timing, start);
+    timing.total = loadClock() - start;
+  };
+  
+  loadScriptsInFile(doc, includesURL, function() { timing.includes = loadClock() - start; ready(); });
+  loadURLIntoDiv(doc, detailURL, divName, function() { timing.detail = loadClock() - start; ready(); });
+  loadFiles(scriptURLs, function(texts) { scriptTexts = texts; timing.fetchScripts = loadClock() - start; ready(); });
+}
+
+// Loads the given sub-file into its div, which is collapsed until then, and expands it. If the sub-file
+// has already been loaded, toggles whether its div is expanded. The sub-file's detail, summary and scripts 
+// are fetched concurrently. Its prolog, script and epilog are run in order once the detail and summary have 
+// been inserted, since they refer to both. Requests for the sub-file's script and epilog are skipped if its 
+// manifest shows that they're empty. If continuationFunc is provided, it is called once the sub-file has been
+// loaded, including when it is requested while the sub-file is already being loaded.
 function loadSubFile(detailDoc, fileID, detailURL, detailDivName, sumDoc, sumURL, sumDivName, scriptURL, continuationFunc) {
-  if(!getFile(fileID, "loaded")) {
-    loadURLIntoDiv(detailDoc, detailURL, detailDivName,
-                   function() { 
-                     loadURLIntoDiv(sumDoc, sumURL, sumDivName,
-                                    function() { 
-                                      loadjscssfile(scriptURL+".prolog", "text/javascript", 
-                                        function() {loadjscssfile(scriptURL, "text/javascript", 
-                                          function() { loadjscssfile(scriptURL+".epilog", "text/javascript", continuationFunc); } 
-                                        ); }
-                                      );
-                                    } ); } );
+  var detailDiv = detailDoc.getElementById(detailDivName);
+  if(getFile(fileID, "loaded")) {
+    if(typeof continuationFunc !== 'undefined') continuationFunc();
+    else if(detailDiv)
+      detailDiv.className=(detailDiv.className=='hidden')?'unhidden':'hidden';
+    return;
+  }
+  // Repeated requests made while the sub-file is being loaded continue once it has been loaded
+  if(getFile(fileID, "loading")) {
+    if(typeof continuationFunc !== 'undefined') getFile(fileID, "continuations").push(continuationFunc);
+    return;
+  }
+  recordFile(fileID, "loading", 1);
+  recordFile(fileID, "continuations", (typeof continuationFunc !== 'undefined'? [continuationFunc]: []));
+  // Record the sub-file's div so that navigation can expand it once it has been loaded
+  recordFile(fileID, "detailDiv", detailDiv);
+  
+  var start = loadClock();
+  var timing = {};
+  loadTimings[detailURL] = timing;
+  
+  var manifest = getFile(fileID, "manifest");
+  var scriptURLs = [scriptURL+".prolog",
+                    (typeof manifest !== 'undefined' && manifest.scriptBytes==0? undefined: scriptURL),
+                    (typeof manifest !== 'undefined' && manifest.epilogBytes==0? undefined: scriptURL+".epilog")];
+  var scriptTexts;
+  // The number of the detail, summary and scripts that have not yet arrived
+  var pending = 3;
+  var ready = function() {
+    if(--pending > 0) return;
+    runFileScripts(scriptURLs, scriptTexts, timing, start);
+    timing.total = loadClock() - start;
+    var continuations = getFile(fileID, "continuations");
+    recordFile(fileID, "continuations", []);
+    for(var i=0; i<continuations.length; i++) continuations[i]();
+  };
+  
+  loadURLIntoDiv(detailDoc, detailURL, detailDivName,
+                 function() { 
+                   if(detailDiv) detailDiv.className='unhidden';
+                   timing.detail = loadClock() - start;
+                   ready();
+                 });
+  loadURLIntoDiv(sumDoc, sumURL, sumDivName, function() { timing.summary = loadClock() - start; ready(); });
+  loadFiles(scriptURLs, function(texts) { scriptTexts = texts; timing.fetchScripts = loadClock() - start; ready(); });
+}
+
+// Records the manifest of the sub-file with the given fileID that is loaded into the block with the given ID:
+// the size of its detail body, the number of sub-files and blocks directly inside it and the sizes of its
+// script and script epilog. Shows a description of the sub-file next to its collapsed block.
+function fileManifest(fileID, blockID, detailBytes, numSubFiles, numBlocks, scriptBytes, epilogBytes) {
+  recordFile(fileID, "manifest", {detailBytes: detailBytes, numSubFiles: numSubFiles, numBlocks: numBlocks, 
+                                  scriptBytes: scriptBytes, epilogBytes: epilogBytes});
+  
+  var span = document.getElementById("manifest"+blockID);
+  if(span) {
+    var size = (detailBytes < 1024? detailBytes+" B": 
+                detailBytes < 1048576? (detailBytes/1024).toFixed(1)+" KB": 
+                                       (detailBytes/1048576).toFixed(1)+" MB");
+    span.innerHTML = "["+size+", "+numBlocks+" block"+(numBlocks==1?"":"s")+
+                     (numSubFiles>0? ", "+numSubFiles+" nested file"+(numSubFiles==1?"":"s"): "")+"]";
   }
 }
 
+// The aggregate statistics of the entire log, relative to which the statistics of file levels are shown
+var logTotalStats;
+// The IDs of the blocks of the file levels whose statistics have been recorded, mapped to their statistics
+var blockFileStats = {};
+
+// Records the aggregate statistics of the contents of the sub-file with the given fileID that is loaded into 
+// the block with the given ID: {tags:, traceObs:, traceVals:{traceKey:{n:, min:, max:, sum:}, ...}}.
+// Annotates the sub-file's collapsed block with a color that shows the fraction of the log's tags in the
+// sub-file and with the statistics of its trace observations.
+function fileStats(fileID, blockID, stats) {
+  recordFile(fileID, "stats", stats);
+  blockFileStats[blockID] = stats;
+  if(typeof logTotalStats !== 'undefined') showFileStats(blockID, stats);
+}
+
+// Records the aggregate statistics of the entire log and annotates all the file levels recorded so far
+function logStats(stats) {
+  logTotalStats = stats;
+  for(var blockID in blockFileStats) { if(blockFileStats.hasOwnProperty(blockID)) {
+    showFileStats(blockID, blockFileStats[blockID]);
+  } }
+}
+
+// Annotates the collapsed block with the given ID with the given statistics of its file level
+function showFileStats(blockID, stats) {
+  var span = document.getElementById("manifest"+blockID);
+  if(!span) return;
+  
+  // The heat of a file level is the fraction of the log's tags inside it, on a log scale
+  var heat = (logTotalStats.tags>0? Math.log(1+stats.tags) / Math.log(1+logTotalStats.tags): 0);
+  span.style.backgroundColor = "hsl(0, 100%, "+Math.round(100 - heat*50)+"%)";
+  
+  var title = stats.tags+" tags ("+(logTotalStats.tags>0? (100*stats.tags/logTotalStats.tags).toFixed(1): 0)+"% of the log)";
+  if(stats.traceObs>0) title += ", "+stats.traceObs+" trace observations";
+  for(var key in stats.traceVals) { if(stats.traceVals.hasOwnProperty(key)) {
+    var v = stats.traceVals[key];
+    title += "\n"+key+": n="+v.n+", min="+v.min+", max="+v.max+", sum="+v.sum;
+  } }
+  span.title = title;
+}
+
 function loadAnchorScriptsFile(anchorFileID, continuationFunc) {
   if(!(anchorFileID in loadedAnchors))
     return loadjscssfile('script/anchor_script.'+anchorFileID, 'text/javascript', 
@@ -387,8 +588,11 @@ function goToAnchor(prefix, suffix, continuationFunc) {
     getFile(prefix, 'loadFunc')(
       function() { goToAnchor(prefix, suffix, continuationFunc); }
     );
-  // Otherwise, if it has already been loaded, load its child file within the file ID
+  // Otherwise, if it has already been loaded, make sure that it is expanded since it may have been hidden 
+  // after it was loaded, and load its child file within the file ID
   } else {
+    var detailDiv = getFile(prefix, "detailDiv");
+    if(detailDiv && detailDiv.className=='hidden') detailDiv.className='unhidden';
     goToAnchor(prefix, suffix, continuationFunc);
   }
   return undefined;
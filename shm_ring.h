@@ -0,0 +1,220 @@
+#pragma once
+
+#include <string>
+#include <streambuf>
+#include <stdio.h>
+#include <sys/types.h>
+
+namespace sight {
+
+// A single-producer, single-consumer ring buffer in POSIX shared memory. Under node-local aggregation
+// each process streams its structure output through its own ring to an aggregator process on the same
+// node, which merges the streams of all the node's processes as they are produced. Under SIGHT_SHM_LAYOUT
+// the application streams its structure through a ring directly to slayout.
+// A reader or writer that must wait for the other side sleeps on a futex (on Linux), which the other side
+// only wakes if it has announced that it is waiting, so neither side makes a system call while data flows.
+// The header records the writer's process ID so that readers can ignore stale rings left behind by writers 
+// that crashed and stop waiting for data from writers that died without closing their ring. Writers likewise 
+// drop their output rather than wait for space once their reader has exited, and remove the ring's name once 
+// their reader has attached so that the segment does not outlive the two processes.
+class shmRing {
+  // The header at the start of the shared memory segment
+  typedef struct {
+    // Identifies segments that have been fully initialized by their writer
+    volatile unsigned int magic;
+    // Set by the writer once it has written all of its data
+    volatile int writerDone;
+    // The process ID of the writer
+    pid_t writerPid;
+    // Set by the reader once it has attached to the ring, along with its process ID
+    volatile int readerAttached;
+    pid_t readerPid;
+    // The number of bytes of data that fit in the ring
+    unsigned long long capacity;
+    // The total number of bytes ever written to and read from the ring
+    volatile unsigned long long head;
+    volatile unsigned long long tail;
+    // Futex words that are incremented whenever data is added to or space is freed in the ring
+    volatile int dataSeq;
+    volatile int spaceSeq;
+    // Set by the reader and writer while they are waiting for data or space, respectively
+    volatile int readerWaiting;
+    volatile int writerWaiting;
+    // The number of bytes the writer dropped or spilled to a file because the ring was full
+    volatile unsigned long long droppedBytes;
+    volatile unsigned long long spilledBytes;
+  } header;
+  
+  // The name of the shared memory segment
+  std::string name;
+  
+  // Points to the mapped segment and its data section
+  header* hdr;
+  char* data;
+  size_t mapSize;
+  
+  // The reader process if it is a child of the writer, or -1 if it is not known
+  pid_t readerChild;
+  // Records whether the writer has found that the reader exited and whether it has removed the ring's name.
+  // readerGone may be set by a thread other than the one that writes the ring.
+  volatile bool readerGone;
+  bool unlinked;
+  
+  shmRing(const std::string& name, header* hdr, size_t mapSize);
+  
+  // Waits until the other side increments the given futex word from seq or a short timeout passes
+  static void wait(volatile int* word, int seq);
+  
+  // Increments the given futex word and wakes the other side, which is waiting on it
+  static void wake(volatile int* word);
+  
+  // Returns whether the process that writes the ring with the given header is still running
+  static bool writerAlive(const header* hdr);
+  
+  // Returns whether the reader of this ring may still be running
+  bool readerAlive();
+  
+  public:
+  ~shmRing();
+  
+  // Creates a fresh ring with the given name and capacity, to be written by the calling process
+  static shmRing* create(const std::string& name, size_t capacity);
+  
+  // Attaches to the ring with the given name to read from it, waiting up to timeoutSec seconds for its writer to create it
+  static shmRing* attach(const std::string& name, int timeoutSec);
+  
+  // Returns the name of the ring of the process with the given node-local rank within the aggregation with the given 
+  // name, which should identify the job to make sure that concurrent and prior jobs on the node use different rings
+  static std::string ringName(const std::string& aggName, int localRank);
+  
+  // Records that the ring's reader is the given child process of the writer, which lets the writer notice 
+  // if the reader exits before attaching to the ring
+  void setReaderProcess(pid_t pid) { readerChild = pid; }
+  
+  // Called by the writer's process, possibly from a thread other than the one that writes the ring, once it finds 
+  // that the reader has exited. All the data written from then on is dropped rather than waiting for space.
+  void abandon();
+  bool abandoned() const { return readerGone; }
+  
+  // Appends len bytes to the ring, waiting for the reader whenever the ring is full. If the reader has
+  // exited the data is dropped.
+  void write(const char* buf, size_t len);
+  
+  // Appends as many of the len bytes as currently fit in the ring without waiting. Returns the number written.
+  size_t tryWrite(const char* buf, size_t len);
+  
+  // Returns the ring's capacity and the number of bytes that may currently be written to it without waiting
+  size_t capacity() const { return hdr->capacity; }
+  size_t freeSpace() const;
+  
+  // Reads up to len bytes from the ring, waiting until at least one byte is available. Returns the number
+  // of bytes read, which is 0 only once the writer has closed the ring or exited and all of its data has been read.
+  size_t read(char* buf, size_t len);
+  
+  // Called by the writer to indicate that it will write no more data
+  void close();
+  
+  // Called by the writer to record bytes it dropped or spilled to a file because the ring was full
+  void addDropped(size_t bytes) { hdr->droppedBytes += bytes; }
+  void addSpilled(size_t bytes) { hdr->spilledBytes += bytes; }
+  unsigned long long droppedBytes() const { return hdr->droppedBytes; }
+  unsigned long long spilledBytes() const { return hdr->spilledBytes; }
+  
+  // Removes the ring's name from the system. The segment is released once all processes unmap it.
+  void unlink();
+}; // class shmRing
+
+// Stream buffer that writes into a shmRing, batching small writes.
+// If a spill file is provided, data that does not fit in a full ring is appended to the file rather than 
+// waiting for the reader, and is copied into the ring ahead of any later data once it has space.
+class shmRingOutBuf : public std::streambuf {
+  shmRing* ring;
+  char* outBuf;
+  size_t outBufSize;
+  size_t outBufLen;
+  
+  // The spill file, or -1 if writes wait for space in the ring, and the range of its bytes that have not 
+  // yet been copied into the ring
+  int spillFD;
+  long long spillHead;
+  long long spillTail;
+  // Buffer used to copy data from the spill file into the ring
+  char* spillBuf;
+  
+  public:
+  shmRingOutBuf(shmRing* ring, size_t outBufSize=65536, std::string spillFName="");
+  ~shmRingOutBuf();
+  
+  // Writes out any buffered data and closes the ring
+  void close();
+  
+  protected:
+  virtual int_type overflow(int_type c);
+  virtual std::streamsize xsputn(const char* s, std::streamsize num);
+  virtual int sync();
+  
+  // Writes the given data to the ring or, if it is full, to the spill file
+  void put(const char* s, size_t len);
+  
+  // Copies as much of the spilled data into the ring as fits, waiting for space if wait is true
+  // until all of it has been copied
+  void drainSpill(bool wait);
+}; // class shmRingOutBuf
+
+// Stream buffer placed in front of the buffer that writes into a shmRing, which drops the structure 
+// written through it while the ring is nearly full rather than waiting for the reader. Only whole 
+// records are dropped and the tag structure remains well-formed: once dropping starts, text and tags 
+// that are entered are dropped along with everything until their exit, while the exits of tags entered 
+// before dropping started are kept. Dropping stops once the ring has drained and all the dropped tags
+// have been exited. As in loopCompressBuf, brackets in the stream only delimit tags since the 
+// application's text has its brackets escaped.
+class shmRingDropBuf : public std::streambuf {
+  std::streambuf* baseBuf;
+  shmRing* ring;
+  
+  // Dropping starts when the ring holds more than startFill bytes and stops when it holds fewer than stopFill
+  size_t startFill;
+  size_t stopFill;
+  
+  // The kind of the current record: 0 if we're between records, 't' for text, '[' for a tag whose kind 
+  // is not yet known, 'e' for an entry tag, 'b' for the entry tag of a base class, which is followed 
+  // by the entry of its derived class and 'x' for an exit tag
+  char kind;
+  // Whether the last record was a base class entry and whether it was dropped
+  bool lastBase;
+  bool lastDropped;
+  
+  // Records whether we're dropping, the number of dropped tags that have not yet been exited and 
+  // whether the next entry must be kept because its base class entries were kept
+  bool dropping;
+  int dropDepth;
+  bool keepEntry;
+  // The current record while we're dropping, which is kept or dropped once it is complete
+  std::string rec;
+  
+  // The number of bytes and records dropped
+  long long numDroppedBytes;
+  long numDroppedRecs;
+  
+  public:
+  shmRingDropBuf(std::streambuf* baseBuf, shmRing* ring);
+  
+  long long droppedBytes() const { return numDroppedBytes; }
+  long droppedRecs() const { return numDroppedRecs; }
+  
+  protected:
+  virtual int_type overflow(int_type c);
+  virtual std::streamsize xsputn(const char* s, std::streamsize num);
+  virtual int sync();
+  
+  // Called at the start of each record to decide whether to start or stop dropping
+  void startRecord(bool isTag);
+  
+  // Appends the given part of the current record to the output or to rec
+  void emit(const char* s, size_t len);
+  
+  // Called at the end of each record
+  void endRecord();
+}; // class shmRingDropBuf
+
+} // namespace sight
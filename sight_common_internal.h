@@ -381,6 +381,8 @@ class escapedStr {
 
 class structureParser {
   public:
+  virtual ~structureParser() {}
+  
  
   // Reads more data from the data source, returning the type of the next tag read and the properties of 
   // the object it denotes.
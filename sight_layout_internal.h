@@ -9,6 +9,8 @@
 #include <sstream>
 #include <fstream>
 #include <stdarg.h>
+#include <sys/time.h>
+#include <sys/types.h>
 #include "sight_common.h"
 
 namespace sight {
@@ -24,12 +26,20 @@ namespace layout {
 // It is assumed that all objects are hierarchically scoped, in that objects are exted in the 
 //   reverse order of their entry. The layout engine keeps track of the entry/exit stacks and 
 //   ensures that the appropriate object pointers are passed to exit handlers.
+// The variants of a log are read from separate structure files, each of which is a separate stream of tags. 
+// A variant enter handler is called before each variant is laid out and a variant exit handler after, with 
+// lastVariant set for the last variant of a given variants tag, making it possible for widgets to keep 
+// separate state for each stream.
 typedef void* (*layoutEnterHandler)(properties::iterator props);
 typedef void (*layoutExitHandler)(void*);
+typedef void (*layoutVariantEnterHandler)();
+typedef void (*layoutVariantExitHandler)(bool lastVariant);
 class layoutHandlerInstantiator : public sight::common::LoadTimeRegistry{
   public:
   static std::map<std::string, layoutEnterHandler>* layoutEnterHandlers;
   static std::map<std::string, layoutExitHandler>*  layoutExitHandlers;
+  static std::list<layoutVariantEnterHandler>*      layoutVariantEnterHandlers;
+  static std::list<layoutVariantExitHandler>*       layoutVariantExitHandlers;
 
   layoutHandlerInstantiator();
   /*  // Initialize the handlers mappings, using environment variables to make sure that
@@ -341,6 +351,41 @@ protected:
 }; // class dbgBuf
 
 
+// Aggregate statistics of the contents of a file level, including all the file levels nested inside it,
+// which are computed while the log is laid out. They let the viewer annotate the outline of a log
+// with the amount of activity in each collapsed file level without loading it.
+class fileLevelStats {
+  public:
+  // The number of tags and trace observations
+  long numTags;
+  long numTraceObs;
+  
+  // The number, minimum, maximum and sum of the numeric values observed for a trace attribute
+  class valStats {
+    public:
+    long n;
+    double min, max, sum;
+    valStats() : n(0), min(0), max(0), sum(0) {}
+    void add(double v);
+    void add(const valStats& that);
+  };
+  
+  // Maps each trace attribute to the statistics of its values. Time spent in a region is recorded
+  // by timeMeasure traces, so the sum of their attributes is the time spent in their file level.
+  std::map<std::string, valStats> traceVals;
+  
+  fileLevelStats() : numTags(0), numTraceObs(0) {}
+  
+  // Adds the given tag to these statistics
+  void addTag(const properties* props);
+  
+  // Adds the statistics of a nested file level to these statistics
+  void add(const fileLevelStats& that);
+  
+  // Returns the representation of these statistics as a JavaScript map
+  std::string strJS() const;
+}; // class fileLevelStats
+
 // Stream that uses dbgBuf
 class dbgStream : public common::dbgStream
 {
@@ -352,6 +397,13 @@ class dbgStream : public common::dbgStream
   // Files that contain the commands to be executed before/after all the commands in the script file are executed
   std::list<std::ofstream*> scriptPrologFiles; 
   std::list<std::ofstream*> scriptEpilogFiles; 
+  // The number of file levels and blocks directly nested within each file level on the stack. Together
+  // with the sizes of its files they form the file level's manifest, which lets the viewer describe
+  // the contents of a collapsed file level without loading it.
+  std::list<int>            fileNumSubFiles;
+  std::list<int>            fileNumBlocks;
+  // The aggregate statistics of the contents of each file level on the stack
+  std::list<fileLevelStats> fileStats;
   // Global script file that includes any additional scripts required by widgets 
   std::ofstream             scriptIncludesFile;
   // Records the paths of the scripts that have already been included. Maps script paths to their types.
@@ -394,6 +446,9 @@ public:
   void userAccessing();
   void ownerAccessing();
   
+  // Adds the given tag to the statistics of the current file level
+  void recordTag(const properties* props) { if(fileStats.size()>0) fileStats.back().addTag(props); }
+  
   // Returns the file stream to the file that contains the commands to be executed when the current sub-file is loaded
   std::ofstream* getCurScriptFile() const;
     
@@ -516,10 +571,70 @@ public:
   ~indent();
 };
 
+// Schedules the graphviz dot jobs that lay out the graphs emitted by widgets. At most maxJobs dot processes run
+// at a time (SIGHT_DOT_JOBS, defaulting to the number of processors) and the laid out xdot files are cached 
+// under a key that hashes the normalized text of the dot graph so that graphs that recur (e.g. the same module 
+// graph in every timestep or in multiple merged runs) are laid out only once. The cache lives in directory 
+// SIGHT_DOT_CACHE if it is set and in the dotCache sub-directory of the output directory otherwise.
+// The time spent in graph layout is reported to stderr once all the jobs have completed.
+class dotLayoutScheduler {
+  // Describes a running dot process
+  typedef struct {
+    // The key of the graph being laid out
+    std::string key;
+    // The time when the process was started
+    struct timeval start;
+  } job;
+  
+  // The maximum number of dot processes that may run at the same time
+  static int maxJobs;
+  
+  // Maps the process IDs of the currently running dot processes to their jobs
+  static std::map<pid_t, job> running;
+  
+  // Maps the keys of the graphs currently being laid out to the files into which their layouts must be placed
+  static std::map<std::string, std::list<std::string> > waiting;
+  
+  // The directory that holds the cached layouts
+  static std::string cacheDir;
+  
+  // Statistics of the layout work: the number of dot processes that were run, the number of graphs whose 
+  // layouts were reused from the cache or from a job already running, the total time the dot processes took 
+  // from fork to reap and the time spent waiting for them to complete after all graphs were submitted
+  static long numJobs;
+  static long numHits;
+  static double layoutTime;
+  static double waitTime;
+  
+  // Initializes the scheduler on its first use
+  static void init();
+  
+  // Returns the key of the given dot graph text, which is the same for any two graphs that differ only in whitespace
+  // outside of quoted strings
+  static std::string key(const std::string& dot);
+  
+  // Waits for at least one running dot process to complete if block is true, or collects the results of any 
+  // processes that have already completed otherwise. Only the processes forked by the scheduler are waited on.
+  static void reap(bool block);
+  
+  // Places the cached layout with the given key into file placedFName
+  static void placeLayout(const std::string& key, const std::string& placedFName);
+  
+  public:
+  // Lays out the dot graph in file dotFName, placing its xdot layout into file placedFName when it is ready
+  static void layout(const std::string& dotFName, const std::string& placedFName);
+  
+  // Waits for all the outstanding layout jobs to complete and reports the time spent on them
+  static void waitAll();
+}; // class dotLayoutScheduler
+
 // Given a string, returns a version of the string with all the control characters that may appear in the 
 // string escaped to that the string can be written out to Dbg::dbg with no formatting issues.
 // This function can be called on text that has already been escaped with no harm.
 std::string escape(std::string s);
+
+// Returns the given string as a JSON string literal, which may also be used in JavaScript
+std::string jsonStr(const std::string& s);
   
 int dbgprintf(const char * format, ... );
 
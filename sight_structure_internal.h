@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <deque>
 #include <vector>
 #include <set>
 #include <map>
@@ -10,9 +11,15 @@
 #include <ostream>
 #include <fstream>
 #include <stdarg.h>
+#include <string.h>
 #include <assert.h>
+#include <time.h>
+#include <pthread.h>
 #include "sight_common.h"
 #include "utils.h"
+#include "shm_ring.h"
+#include "frame_compress.h"
+#include "tag_loops.h"
 #include "tools/callpath/include/Callpath.h"
 #include "tools/callpath/include/CallpathRuntime.h"
 
@@ -47,30 +54,343 @@ void NullSightInit(int argc, char** argv, std::string title="Debug Output", std:
 
 class dbgStream;
 
+/*********************
+ ***** tickClock *****
+ *********************/
+
+// The clock used to time both the application (timeMeasure) and Sight itself (sightOverhead). Time is read from 
+// the processor's invariant time stamp counter if it has one and from clock_gettime(CLOCK_MONOTONIC_RAW), which is 
+// serviced by the vDSO without entering the kernel, otherwise. Time is kept as integral clock ticks, which are 
+// converted to seconds using the rate of the clock measured when it was calibrated.
+class tickClock {
+  public:
+  // Records whether the clock has been calibrated
+  static bool calibrated;
+  
+  // Records whether time is read from the time stamp counter (true) or clock_gettime() (false)
+  static bool useTSC;
+  
+  // The number of clock ticks per second
+  static double ticksPerSec;
+  
+  // Calibrates the clock. May be called again to re-calibrate.
+  static void calibrate();
+  
+  // Returns the current value of the clock, in ticks
+  static unsigned long long readTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    if(useTSC) {
+      unsigned int lo, hi;
+      __asm__ volatile("rdtsc" : "=a" (lo), "=d" (hi));
+      return ((unsigned long long)hi << 32) | lo;
+    }
+#endif
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+    return (unsigned long long)t.tv_sec*1000000000ULL + t.tv_nsec;
+  }
+  
+  // Converts the given number of ticks to seconds
+  static double ticksToSec(long long ticks) { return ticks / ticksPerSec; }
+}; // class tickClock
+
+/*************************
+ ***** sightOverhead *****
+ *************************/
+
+// Measures how much time the application spends inside Sight itself. When SIGHT_OVERHEAD is set, Sight's 
+// internal hot paths are wrapped in overheadTimers, which accumulate the number of calls and the number 
+// of clock ticks spent in them. Measurements are aggregated by the category of work, the name of what it was 
+// done on behalf of (e.g. the widget type for tag emission and output writes) and the application code that 
+// called into Sight to do it.
+// The summary is written to <workDir>/overhead when the dbgStream is destroyed. If SIGHT_OVERHEAD_TRACE is 
+// also set, it is emitted into the log itself as a trace when the application exits.
+// Measurements may be recorded concurrently by multiple threads.
+class sightOverhead {
+  public:
+  // The categories of Sight-internal work that are measured separately
+  typedef enum {enterTag, exitTag, stackwalk, attrQuery, traceEmit, structWrite, numCategories} category;
+  static std::string cat2str(category c);
+  
+  // The stack of return addresses from which Sight was called to do some measured work
+  class callSite {
+    public:
+    static const int maxFrames=8;
+    void* frames[maxFrames];
+    int numFrames;
+    
+    callSite() : numFrames(0) {}
+    
+    // Returns the call site of the caller
+    static callSite here();
+    
+    bool operator<(const callSite& that) const;
+    
+    // Returns the innermost frames of the call site outside of Sight, described by their symbols. Sight's 
+    // frames can only be told apart if the application was linked with -rdynamic.
+    std::string str() const;
+  };
+  
+  // A category of work, the name of what it was done on behalf of and the call site that it was done for
+  class site {
+    public:
+    category c;
+    std::string name;
+    callSite cs;
+    
+    site(category c, const std::string& name, const callSite& cs) : c(c), name(name), cs(cs) {}
+    
+    bool operator<(const site& that) const;
+  };
+  
+  // Call count and ticks accumulated by a given category and site
+  class stats {
+    public:
+    long calls;
+    unsigned long long ticks;
+    stats() : calls(0), ticks(0) {}
+  };
+  
+  // Records whether overhead measurement is currently enabled
+  static bool enabled;
+  
+  // The number of timers that are currently running in the calling thread. Only time spent in its outermost 
+  // timer is added to totalTicks to make sure that nested measurements (e.g. attribute queries during a tag's 
+  // emission) are not counted twice.
+  static __thread int depth;
+  static unsigned long long totalTicks;
+  
+  // The number of ticks the calling thread has spent identifying call sites and recording measurements.
+  // Each timer subtracts the portion of it that was spent while it ran, by the timers nested inside it, 
+  // from its own ticks so that the cost of measuring is not counted as Sight's overhead.
+  static __thread unsigned long long profTicks;
+  
+  // Maps each category and site to the statistics of the work done on its behalf
+  static std::map<site, stats>* sites;
+  
+  // Protects totalTicks and sites
+  static pthread_mutex_t sitesMutex;
+  
+  // The tick count when measurement began and the number of ticks spent by all threads identifying call sites 
+  // and recording measurements, which are excluded from the application's run time since they are only 
+  // spent while measuring
+  static unsigned long long startTicks;
+  static unsigned long long attributionTicks;
+  
+  // Function that emits the summary into the log as a trace. It is registered by the trace widget 
+  // so that the core does not depend on it, and is NULL if the trace widget is not linked in.
+  static void (*traceEmitter)();
+  
+  // Enables measurement if SIGHT_OVERHEAD is set. Called by SightInit.
+  static void init();
+  
+  // Returns the number of seconds the application has run since measurement began
+  static double elapsedSec();
+  
+  // Adds a single measured call of the given category, name and call site
+  static void record(category c, const std::string& name, const callSite& cs, unsigned long long ticks);
+  
+  // Writes the summary of all measurements to the given stream
+  static void report(std::ostream& out);
+  
+  // Called at application exit to emit the summary into the log if requested
+  static void atExit();
+}; // class sightOverhead
+
+// Measures the time spent in its scope and adds it to sightOverhead under the given category and name, and
+// the call site of the code that created it. Does nothing beyond checking a flag when overhead measurement
+// is disabled.
+class overheadTimer {
+  sightOverhead::category c;
+  std::string name;
+  sightOverhead::callSite cs;
+  unsigned long long start;
+  unsigned long long profStart;
+  bool on;
+  
+  public:
+  overheadTimer(sightOverhead::category c, const std::string& name) : c(c), on(sightOverhead::enabled) {
+    if(on) begin(name);
+  }
+  
+  overheadTimer(sightOverhead::category c, const char* name) : c(c), on(sightOverhead::enabled) {
+    if(on) begin(name);
+  }
+  
+  ~overheadTimer() {
+    if(on) {
+      unsigned long long ticks = tickClock::readTicks() - start;
+      unsigned long long nestedProf = sightOverhead::profTicks - profStart;
+      ticks = (ticks > nestedProf? ticks - nestedProf: 0);
+      sightOverhead::depth--;
+      sightOverhead::record(c, name, cs, ticks);
+    }
+  }
+  
+  private:
+  void begin(const std::string& name) {
+    this->name = name;
+    cs = sightOverhead::callSite::here();
+    sightOverhead::depth++;
+    profStart = sightOverhead::profTicks;
+    start = tickClock::readTicks();
+  }
+}; // class overheadTimer
+
+/*************************
+ ***** packedIntSeq *****
+ *************************/
+
+// A sequence of integers that is used as the encoding of variantIDs and locations. These are copied, hashed and 
+// compared on every anchor and stream record operation, so the sequence keeps up to inlineCap elements inline 
+// (spilling to the heap only for deeper sequences) and maintains the hash of each of its prefixes. This makes 
+// the hash of the full sequence or of any prefix available in O(1) and lets comparisons of sequences that 
+// differ reject them without looking at their elements. Sequences are only ever modified near their end, 
+// so keeping the prefix hashes current is cheap.
+class packedIntSeq {
+  public:
+  static const int inlineCap=8;
+  
+  protected:
+  int n;
+  int cap;
+  // Inline storage for the elements and prefix hashes, used while cap==inlineCap
+  int    inlVals[inlineCap];
+  size_t inlHashes[inlineCap];
+  // Heap storage, used once the sequence grows beyond inlineCap
+  int*    heapVals;
+  size_t* heapHashes;
+  
+  int*          vals()         { return heapVals? heapVals: inlVals; }
+  const int*    vals()   const { return heapVals? heapVals: inlVals; }
+  size_t*       hashes()       { return heapHashes? heapHashes: inlHashes; }
+  const size_t* hashes() const { return heapHashes? heapHashes: inlHashes; }
+  
+  // The hash of the empty sequence and the hash of the sequence h extended with v
+  static size_t seed() { return (size_t)14695981039346656037ULL; }
+  static size_t extend(size_t h, int v) { return (h ^ (size_t)(unsigned int)v) * (size_t)1099511628211ULL; }
+  
+  // Recomputes the prefix hashes of all the prefixes that end at or after index i
+  void rehashFrom(int i) {
+    int* v = vals(); size_t* h = hashes();
+    for(; i<n; i++) h[i] = extend(i==0? seed(): h[i-1], v[i]);
+  }
+  
+  // Makes sure the sequence can hold at least c elements
+  void reserve(int c) {
+    if(c <= cap) return;
+    int newCap = cap;
+    while(newCap < c) newCap *= 2;
+    int*    newVals   = new int[newCap];
+    size_t* newHashes = new size_t[newCap];
+    memcpy(newVals,   vals(),   n*sizeof(int));
+    memcpy(newHashes, hashes(), n*sizeof(size_t));
+    freeHeap();
+    heapVals = newVals;
+    heapHashes = newHashes;
+    cap = newCap;
+  }
+  
+  void freeHeap() {
+    if(heapVals) { delete[] heapVals; delete[] heapHashes; }
+    heapVals = NULL;
+    heapHashes = NULL;
+  }
+  
+  public:
+  packedIntSeq() : n(0), cap(inlineCap), heapVals(NULL), heapHashes(NULL) {}
+  packedIntSeq(const packedIntSeq& that) : n(0), cap(inlineCap), heapVals(NULL), heapHashes(NULL) { *this = that; }
+  ~packedIntSeq() { freeHeap(); }
+  
+  packedIntSeq& operator=(const packedIntSeq& that) {
+    if(this == &that) return *this;
+    reserve(that.n);
+    n = that.n;
+    memcpy(vals(),   that.vals(),   n*sizeof(int));
+    memcpy(hashes(), that.hashes(), n*sizeof(size_t));
+    return *this;
+  }
+  
+  int size() const { return n; }
+  bool empty() const { return n==0; }
+  int operator[](int i) const { return vals()[i]; }
+  int back() const { assert(n>0); return vals()[n-1]; }
+  
+  void push_back(int v) {
+    reserve(n+1);
+    vals()[n] = v;
+    hashes()[n] = extend(n==0? seed(): hashes()[n-1], v);
+    n++;
+  }
+  void pop_back() { assert(n>0); n--; }
+  void clear() { n=0; }
+  
+  // Sets the element at index i to v
+  void set(int i, int v) {
+    assert(i>=0 && i<n);
+    vals()[i] = v;
+    rehashFrom(i);
+  }
+  
+  // Returns the hash of the first len elements, or of the whole sequence
+  size_t prefixHash(int len) const { assert(len<=n); return len==0? seed(): hashes()[len-1]; }
+  size_t hash() const { return prefixHash(n); }
+  
+  // Returns whether this sequence is a prefix of that one
+  bool isPrefixOf(const packedIntSeq& that) const {
+    if(n > that.n || prefixHash(n) != that.prefixHash(n)) return false;
+    return memcmp(vals(), that.vals(), n*sizeof(int))==0;
+  }
+  
+  // Returns the estimated number of bytes of memory used by this sequence
+  size_t memUsage() const { return sizeof(packedIntSeq) + (heapVals? cap*(sizeof(int)+sizeof(size_t)): 0); }
+  
+  // Relational operators. Sequences are ordered lexicographically.
+  bool operator==(const packedIntSeq& that) const {
+    return n==that.n && hash()==that.hash() && memcmp(vals(), that.vals(), n*sizeof(int))==0;
+  }
+  bool operator!=(const packedIntSeq& that) const { return !(*this == that); }
+  bool operator< (const packedIntSeq& that) const {
+    const int* a = vals(); const int* b = that.vals();
+    int m = (n < that.n? n: that.n);
+    for(int i=0; i<m; i++) {
+      if(a[i] < b[i]) return true;
+      if(a[i] > b[i]) return false;
+    }
+    return n < that.n;
+  }
+  bool operator<=(const packedIntSeq& that) const { return !(that < *this); }
+  bool operator> (const packedIntSeq& that) const { return that < *this; }
+  bool operator>=(const packedIntSeq& that) const { return !(*this < that); }
+}; // class packedIntSeq
+
 class variantID {
   public:
-  std::list<int> ID;
+  packedIntSeq ID;
   
   variantID() {}
   variantID(int ID) { this->ID.push_back(ID); }
-  variantID(const std::list<int>& ID) : ID(ID) {}
+  variantID(const std::list<int>& ID) {
+    for(std::list<int>::const_iterator i=ID.begin(); i!=ID.end(); i++) this->ID.push_back(*i);
+  }
     
   variantID(std::string serialized) {
-    // Deserialized the comma-separated list of integers into the ID std::list
-    int i=0;
-    size_t next = serialized.find(",", i);
-    while(next<serialized.length()) {
-      ID.push_back(strtol(serialized.substr(i, next-i).c_str(), NULL, 10));
-      next = serialized.find(",", i);
-    }  
+    // Deserialize the comma-separated list of integers into the ID sequence
+    const char* c = serialized.c_str();
+    while(*c != 0) {
+      char* end;
+      ID.push_back(strtol(c, &end, 10));
+      if(end == c) break;
+      c = (*end==','? end+1: end);
+    }
   }
   
   std::string serialize() const {
-    // Serialize the ID std::list into a comma-separated list of integers
+    // Serialize the ID sequence into a comma-separated list of integers
     std::ostringstream s;
-    for(std::list<int>::const_iterator i=ID.begin(); i!=ID.end(); i++) {
-      if(i!=ID.begin()) s << ",";
-      s << *i;
+    for(int i=0; i<ID.size(); i++) {
+      if(i>0) s << ",";
+      s << ID[i];
     }
     return s.str();
   }
@@ -80,6 +400,11 @@ class variantID {
   void enterVariant(int vSuffixID) { ID.push_back(vSuffixID); }
   void exitVariant() { assert(ID.size()>0); ID.pop_back(); }
   
+  // Returns whether this variant is that variant or one of the variants that contain it
+  bool isPrefixOf(const variantID& that) const { return ID.isPrefixOf(that.ID); }
+  
+  size_t hash() const { return ID.hash(); }
+  
   // Relational operators
   bool operator==(const variantID& that) const { return ID==that.ID; }
   bool operator!=(const variantID& that) const { return ID!=that.ID; }
@@ -113,11 +438,22 @@ class streamID {
 extern CallpathRuntime CPRuntime;
 std::string cp2str(const Callpath& cp);
 
+// Returns the serialized call path of the current execution point
+std::string curCallPath();
+
 //Callpath str2cp(std::string str);
 
-// Represents a unique location in the sight output
+// Represents a unique location in the sight output: a list of file levels, each of which holds the index of
+// the current file unit within it and the indexes of the current blocks within that file unit.
+// The levels are packed into a single sequence, with each level encoded as its file index followed by its block
+// indexes and a levelEnd terminator. Since all indexes are non-negative, the lexicographic order of the packed 
+// sequences is the same as that of the lists of levels.
 class location : printable {
-  std::list<std::pair<int, std::list<int> > > l;
+  packedIntSeq l;
+  static const int levelEnd=-1;
+  
+  // Returns the index within l of the start of the last level
+  int lastLevelStart() const;
   
   public:
   location();
@@ -134,6 +470,12 @@ class location : printable {
   bool operator!=(const location& that) const;
   bool operator<(const location& that) const;
 
+  // Returns a hash of this location's contents
+  size_t hash() const;
+  
+  // Returns an estimate of the number of bytes of memory used by this location
+  size_t memUsage() const;
+
   //void print(std::ofstream& ofs) const;
   std::string str(std::string indent="") const;
 };
@@ -154,6 +496,10 @@ class streamLocation {
   bool operator!=(const streamLocation& that) const { return !(*this == that); }
   bool operator< (const streamLocation& that) const { return loc<that.loc || (loc==that.loc && vID<that.vID); }
   
+  size_t hash() const { return loc.hash()*31 + vID.hash(); }
+  
+  size_t memUsage() const { return vID.ID.memUsage() + loc.memUsage(); }
+  
   void enterFileBlock() { loc.enterFileBlock(); }
   void exitFileBlock()  { loc.exitFileBlock(); }
   void enterBlock()     { loc.enterBlock(); }
@@ -163,6 +509,261 @@ class streamLocation {
   { return txt()<<"[streamLocation: vID="<<vID.serialize()<<", loc="<<loc.str()<<"]"; }
 }; // class streamLocation
   
+/***********************
+ ***** anchorTable *****
+ ***********************/
+
+// The integer key under which anchorTable stores the given anchor ID
+inline int anchorTableKey(int ID) { return ID; }
+inline int anchorTableKey(const streamID& ID) { return ID.ID; }
+
+// Records the locations of anchors (the anchorLocs mapping from anchor IDs to locations) and the canonical
+// ID of the anchors at each location (the locAnchorIDs mapping), for anchors with IDs of type IDT and 
+// locations of type LocT. 
+// Since anchor IDs are allocated densely the IDs are stored in a deque indexed by their integer key, with 
+// any IDs whose key is already used by another ID (e.g. IDs of other variants after a merge resumes) kept 
+// in an overflow map. Locations are kept in a hash table keyed by their precomputed hashes, so lookups do not 
+// need to walk or compare trees of locations.
+// Long-running applications create anchors continually, so the table retires entries in generations. 
+// After every compactPeriod newly located anchors it drops the entries from before the previous compaction
+// that are no longer referenced by any anchor object (if trackRefs is true) and, if its memory use exceeds 
+// the cap set via SIGHT_ANCHOR_MEM_MB, the oldest located entries even if they are still referenced. Anchor objects keep their IDs and 
+// locations when their entries are retired. The only effect is that anchors that later reach the same 
+// location are not canonicalized to the ID of the first anchor there and unlocated copies of their ID
+// do not learn its location, which the layout process resolves by ID anyway.
+template<typename IDT, typename LocT>
+class anchorTable {
+  protected:
+  class entry {
+    public:
+    IDT ID;
+    LocT loc;
+    // The number of anchor objects that currently use this ID
+    int refs;
+    // Records whether this slot holds an ID and whether its location is known
+    bool used;
+    bool located;
+    // The generation during which the entry was created or located
+    long gen;
+    entry() : refs(0), used(false), located(false), gen(0) {}
+  };
+  
+  // slots[i] holds the ID with key base+i
+  std::deque<entry> slots;
+  long base;
+  
+  // IDs whose key is already used by another ID in slots
+  std::map<IDT, entry> overflow;
+  
+  // Hash table that maps each location to the canonical ID of its anchors. locBuckets[h % locBuckets.size()]
+  // holds the locations with hash h, and the table doubles in size whenever it holds more than 2 locations 
+  // per bucket.
+  typedef std::list<std::pair<LocT, IDT> > locBucket;
+  std::vector<locBucket> locBuckets;
+  long numLocs;
+  
+  locBucket& getBucket(const LocT& loc) { return locBuckets[loc.hash() % locBuckets.size()]; }
+  
+  void growLocBuckets() {
+    std::vector<locBucket> old(locBuckets.size()*2);
+    old.swap(locBuckets);
+    for(typename std::vector<locBucket>::iterator b=old.begin(); b!=old.end(); b++)
+      for(typename locBucket::iterator i=b->begin(); i!=b->end(); i++)
+        getBucket(i->first).push_back(*i);
+  }
+  
+  // Records whether anchor objects report their references via addRef() and release()
+  bool trackRefs;
+  
+  // The number of anchors located since the last compaction and the number of located anchors after which 
+  // the table is compacted. Each compaction starts a new generation.
+  long numNewlyLocated;
+  static const long compactPeriod=1024;
+  long generation;
+  
+  // Estimated memory used by the locations in the table, the cap on the table's memory use (0 if unlimited),
+  // the peak memory use and the number of entries retired so far
+  size_t locBytes;
+  size_t memCap;
+  size_t peakBytes;
+  long numRetired;
+  
+  public:
+  anchorTable(bool trackRefs) : base(0), locBuckets(64), numLocs(0), trackRefs(trackRefs), numNewlyLocated(0), generation(0), locBytes(0), peakBytes(0), numRetired(0) {
+    memCap = (getenv("SIGHT_ANCHOR_MEM_MB")? strtol(getenv("SIGHT_ANCHOR_MEM_MB"), NULL, 10)*1024*1024: 0);
+  }
+  
+  protected:
+  // Returns the entry of the given ID, creating it if create is true. Returns NULL if the ID has no entry
+  // and create is false.
+  entry* getEntry(const IDT& ID, bool create) {
+    long key = anchorTableKey(ID);
+    
+    // Keys below base belong to retired slots and keys far above the end of the slots are not dense
+    if(key >= base && key < base + (long)slots.size() + 65536) {
+      if(key >= base + (long)slots.size()) {
+        if(!create) return NULL;
+        slots.resize(key - base + 1);
+      }
+      
+      entry& e = slots[key - base];
+      if(e.used && e.ID == ID) return &e;
+      if(!e.used) {
+        if(!create) return NULL;
+        e.used = true;
+        e.ID = ID;
+        e.gen = generation;
+        return &e;
+      }
+    }
+    
+    typename std::map<IDT, entry>::iterator o = overflow.find(ID);
+    if(o != overflow.end()) return &(o->second);
+    if(!create) return NULL;
+    entry& e = overflow[ID];
+    e.used = true;
+    e.ID = ID;
+    e.gen = generation;
+    return &e;
+  }
+  
+  // Removes the given entry from the table
+  void retire(entry& e) {
+    if(e.located) {
+      // Remove this ID from the location index if it is the canonical ID of its location
+      locBucket& b = getBucket(e.loc);
+      for(typename locBucket::iterator i=b.begin(); i!=b.end(); i++) {
+        if(i->second == e.ID && i->first == e.loc) {
+          locBytes -= i->first.memUsage();
+          b.erase(i);
+          numLocs--;
+          break;
+        }
+      }
+      locBytes -= e.loc.memUsage();
+    }
+    e = entry();
+    numRetired++;
+  }
+  
+  public:
+  // Records that another anchor object uses / no longer uses the given ID
+  void addRef(const IDT& ID) {
+    if(!trackRefs) return;
+    getEntry(ID, true)->refs++;
+  }
+  
+  void release(const IDT& ID) {
+    if(!trackRefs) return;
+    entry* e = getEntry(ID, false);
+    if(e && e->refs>0) e->refs--;
+  }
+  
+  // If the location of the given ID is known, sets loc to it and returns true. Otherwise, returns false.
+  bool getLoc(const IDT& ID, LocT& loc) {
+    entry* e = getEntry(ID, false);
+    if(e==NULL || !e->located) return false;
+    loc = e->loc;
+    return true;
+  }
+  
+  // Records the location of the given ID
+  void setLoc(const IDT& ID, const LocT& loc) {
+    entry* e = getEntry(ID, true);
+    if(e->located) locBytes -= e->loc.memUsage();
+    e->loc = loc;
+    e->located = true;
+    e->gen = generation;
+    locBytes += loc.memUsage();
+    
+    if(++numNewlyLocated >= compactPeriod || (memCap>0 && memUsage()>memCap)) compact();
+  }
+  
+  // Returns the canonical ID of the anchors at the given location. If no ID has been associated with this 
+  // location, makes the given ID its canonical ID and returns it.
+  IDT canonicalID(const LocT& loc, const IDT& ID) {
+    locBucket& bucket = getBucket(loc);
+    for(typename locBucket::iterator i=bucket.begin(); i!=bucket.end(); i++)
+      if(i->first == loc) return i->second;
+    
+    bucket.push_back(std::make_pair(loc, ID));
+    locBytes += loc.memUsage();
+    if(++numLocs > 2*(long)locBuckets.size()) growLocBuckets();
+    return ID;
+  }
+  
+  // Retires the entries that are no longer needed or, if the table exceeds its memory cap, the oldest ones
+  void compact() {
+    numNewlyLocated = 0;
+    
+    // Entries from earlier generations that are no longer referenced by any anchor. Entries of the current 
+    // generation are kept since anchors that are about to reach the same location (e.g. a block's start anchor
+    // and the anchor emitted in its tag) may still need to adopt their IDs.
+    if(trackRefs) {
+      for(typename std::deque<entry>::iterator e=slots.begin(); e!=slots.end(); e++)
+        if(e->used && e->refs==0 && e->gen<generation) retire(*e);
+      for(typename std::map<IDT, entry>::iterator e=overflow.begin(); e!=overflow.end(); ) {
+        if(e->second.refs==0 && e->second.gen<generation) { retire(e->second); overflow.erase(e++); }
+        else e++;
+      }
+    }
+    
+    // The oldest located entries, until the table is comfortably within its cap
+    if(memCap>0 && memUsage()>memCap) {
+      for(typename std::map<IDT, entry>::iterator e=overflow.begin(); e!=overflow.end() && memUsage()>memCap*3/4; ) {
+        if(e->second.located) { retire(e->second); overflow.erase(e++); }
+        else e++;
+      }
+      for(typename std::deque<entry>::iterator e=slots.begin(); e!=slots.end() && memUsage()>memCap*3/4; e++)
+        if(e->used && e->located) retire(*e);
+    }
+    
+    // Drop the unused slots at the start of the deque
+    while(slots.size()>0 && !slots.front().used) {
+      slots.pop_front();
+      base++;
+    }
+    // If the table is empty, the next ID allocated may be anywhere
+    if(slots.size()==0) base = 0;
+    
+    generation++;
+  }
+  
+  // Makes this table include all the entries in the given table that it does not already contain
+  void insertAll(const anchorTable& that) {
+    for(typename std::deque<entry>::const_iterator e=that.slots.begin(); e!=that.slots.end(); e++)
+      if(e->used && e->located) { LocT l; if(!getLoc(e->ID, l)) setLoc(e->ID, e->loc); }
+    for(typename std::map<IDT, entry>::const_iterator e=that.overflow.begin(); e!=that.overflow.end(); e++)
+      if(e->second.located) { LocT l; if(!getLoc(e->first, l)) setLoc(e->first, e->second.loc); }
+    for(typename std::vector<locBucket>::const_iterator b=that.locBuckets.begin(); b!=that.locBuckets.end(); b++)
+      for(typename locBucket::const_iterator i=b->begin(); i!=b->end(); i++)
+        canonicalID(i->first, i->second);
+  }
+  
+  // Returns the estimated number of bytes of memory used by this table
+  size_t memUsage() {
+    size_t bytes = sizeof(*this) + slots.size()*sizeof(entry) + overflow.size()*(sizeof(entry)+sizeof(IDT)+4*sizeof(void*)) +
+                   locBuckets.size()*sizeof(locBucket) + numLocs*(sizeof(IDT)+2*sizeof(void*)) + locBytes;
+    if(bytes > peakBytes) peakBytes = bytes;
+    return bytes;
+  }
+  
+  // Returns the number of IDs currently recorded in the table
+  long size() const {
+    long n = overflow.size();
+    for(typename std::deque<entry>::const_iterator e=slots.begin(); e!=slots.end(); e++)
+      if(e->used) n++;
+    return n;
+  }
+  
+  std::string str() {
+    size_t bytes = memUsage();
+    return txt()<<"[anchorTable: #IDs="<<size()<<", #slots="<<slots.size()<<", #overflow="<<overflow.size()<<
+                  ", #locations="<<numLocs<<", #retired="<<numRetired<<", bytes="<<bytes<<
+                  ", peakBytes="<<peakBytes<<(memCap>0? std::string(txt()<<", cap="<<memCap): std::string(""))<<"]";
+  }
+}; // class anchorTable
+
 /* #################### DESIGN NOTES ####################
 Clocks are a mechanism to associate a timestamps with each emitted tag. These timestamps must 
 increase monotonically within a single process' log (they may be equal but never decrease) and
@@ -215,9 +816,13 @@ class clockHandlerInstantiator {
   }
 };
 
+// Base class of all clocks. Rather than stamping every tag with the full state of every clock, sightObj
+// emits a separate clock record whenever a clock has been modified and the layout and merging tools 
+// reconstruct the current value of each clock from the sequence of these records.
 class sightClock
 {
   public:
+  // Adds to props the changes in the value of this clock since the last time setProperties() was called
   virtual properties* setProperties(properties* props)=0;
   // Returns true if the clock has been modified since the time of its registration or the last time modified() was called.
   virtual bool modified()=0;
@@ -261,6 +866,31 @@ class sightObj {
   static bool isActiveClock(std::string clockName, sightClock* c);
 }; // class sightObj
 
+/*
+Some widgets need to set up process-wide state when the application initializes Sight, such as calibrating
+clocks. Since the set of widgets linked into an application is not known in advance, widgets register 
+the functions that do this by creating a class that inherits from SightInitHandlerInstantiator and a static
+instance of it. The constructor of this class adds the widget's functions to SightInitHandlers and these
+are called at the end of SightInit().
+Example:
+  SightInitHandlers->push_back(&widgetInitFunction);
+*/
+
+typedef void (*SightInitHandler)();
+
+class SightInitHandlerInstantiator : public sight::common::LoadTimeRegistry {
+  public:
+  static std::list<SightInitHandler>* SightInitHandlers;
+  
+  SightInitHandlerInstantiator();
+  
+  // Called exactly once for each class that derives from LoadTimeRegistry to initialize its static data structures.
+  static void init();
+  
+  // Calls all the registered handlers
+  static void runAll();
+};
+
 /*
 When merging logs Sight uses Merger objects that take tags of a given type and either merge them into a 
 single tag that combines the properties of the individuals or decide that they cannot be merged and provide
@@ -296,11 +926,25 @@ typedef void (*MergeKeyHandler)(properties::tagType type,
 // streamRecord objects that keep their records. The records are specialized with the given stream ID.
 typedef std::map<std::string, streamRecord*> (*GetMergeStreamRecord)(int streamID);
 
+// Some tags, such as the records of the time clock, are emitted at points that depend on the timing of the 
+// application rather than its logic and thus cannot be aligned across streams. Such tags are consumed out of band 
+// as soon as they are read from a given incoming stream by a handler that records their effect in the stream's 
+// streamRecords. Before any merged tag is emitted, emitters are given the streamRecords of the group of incoming 
+// streams being merged and may add to tags any records that must precede the merged tag on the outgoing stream.
+typedef void (*MergeOutOfBandHandler)(properties::tagType type,
+                                      properties::iterator tag, 
+                                      std::map<std::string, streamRecord*>& inStreamRecords);
+typedef void (*MergeOutOfBandEmitter)(std::map<std::string, streamRecord*>& outStreamRecords,
+                                      std::vector<std::map<std::string, streamRecord*> >& inStreamRecords,
+                                      std::list<std::pair<properties::tagType, properties> >& tags);
+
 class MergeHandlerInstantiator : public sight::common::LoadTimeRegistry {
   public:
   static std::map<std::string, MergeHandler>*    MergeHandlers;
   static std::map<std::string, MergeKeyHandler>* MergeKeyHandlers;
   static std::set<GetMergeStreamRecord>*         MergeGetStreamRecords;
+  static std::map<std::string, MergeOutOfBandHandler>* MergeOutOfBandHandlers;
+  static std::set<MergeOutOfBandEmitter>*               MergeOutOfBandEmitters;
 
   MergeHandlerInstantiator();
   
@@ -577,15 +1221,16 @@ class anchor
   // Maps all anchor IDs to their locations, if known. When we establish forward links we create
   // anchors that are initially not connected to a location (the target location has not yet been reached). Thus,
   // when we reach a given location we may have multiple anchors with multiple IDs all for a single location.
-  // This map maintains the canonical anchor ID for each location. Other anchors are resynched to used this ID 
+  // The table maintains the canonical anchor ID for each location. Other anchors are resynched to used this ID 
   // whenever they are copied. This means that data structures that index based on anchors may need to be 
   // reconstructed after we're sure that their targets have been reached to force all anchors to use their canonical IDs.
-  static std::map<int, location> anchorLocs;
-
-  // Associates each anchor with a unique anchor ID. Useful for connecting multiple anchors that were created
-  // independently but then ended up referring to the same location. We'll record the ID of the first one to reach
-  // this location on locAnchorIDs and the others will be able to adjust themselves by adopting this ID.
-  static std::map<location, int> locAnchorIDs;
+  // The table is allocated on first use and never deallocated so that it is available to static anchors
+  // while they are destroyed.
+  static anchorTable<int, location>* table;
+  static anchorTable<int, location>& getTable();
+  
+  // Sets this anchor's ID, updating the table's reference counts
+  void setID(int newID);
 
   // Itentifies this anchor's location in the file and region hierarchies
   location loc;
@@ -627,27 +1272,22 @@ class anchor
   void linkImg(std::string text="") const;
   
   std::string str(std::string indent="") const;
+  
+  // Returns a description of the anchor table, including its memory use
+  static std::string tableStr();
 };
 
 class AnchorStreamRecord: public streamRecord {
   friend class BlockMerger;
   friend class streamAnchor;
     
-  // Maps all anchor IDs to their locations, if known. When we establish forward links we create
-  // anchors that are initially not connected to a location (the target location has not yet been reached). Thus,
-  // when we reach a given location we may have multiple anchors with multiple IDs all for a single location.
-  // This map maintains the canonical anchor ID for each location. Other anchors are resynched to used this ID 
-  // whenever they are copied. This means that data structures that index based on anchors may need to be 
-  // reconstructed after we're sure that their targets have been reached to force all anchors to use their canonical IDs.
-  std::map<streamID, streamLocation> anchorLocs;
-
-  // Associates each anchor with a unique anchor ID. Useful for connecting multiple anchors that were created
-  // independently but then ended up referring to the same location. We'll record the ID of the first one to reach
-  // this location on locAnchorIDs and the others will be able to adjust themselves by adopting this ID.
-  std::map<streamLocation, streamID> locAnchorIDs;
+  // Maps all anchor IDs to their locations, if known, and each location to the canonical ID of its anchors,
+  // as in the anchor class. streamAnchors do not track their references, so entries are only retired 
+  // when the table exceeds its memory cap.
+  anchorTable<streamID, streamLocation> anchors;
   
   public:
-  AnchorStreamRecord(variantID vID) : streamRecord(vID, "anchor") { /*maxAnchorID=0;*/ }
+  AnchorStreamRecord(variantID vID) : streamRecord(vID, "anchor"), anchors(false) { /*maxAnchorID=0;*/ }
   // vSuffixID: ID that identifies this variant within the next level of variants in the heirarchy
   AnchorStreamRecord(const AnchorStreamRecord& that, int vSuffixID);
   
@@ -916,6 +1556,18 @@ class dbgStream : public common::dbgStream, public sightObj
   dbgBuf defaultFileBuf;
   // Stream to the file where the structure will be written
   std::ofstream *dbgFile;
+  // Buffer that compresses the structure written to dbgFile into frames, if SIGHT_COMPRESS is set
+  frameCompressBuf* frameBuf;
+  // The shared memory ring to the node's aggregator process or to slayout, if node-local aggregation
+  // or SIGHT_SHM_LAYOUT is enabled, and the buffer that writes into it
+  shmRing* ring;
+  shmRingOutBuf* ringBuf;
+  // The process that reads ring, if this process launched it, or -1 otherwise
+  pid_t ringReaderPid;
+  // Buffer that drops structure while the ring is nearly full, if SIGHT_RING_OVERFLOW is drop
+  shmRingDropBuf* dropBuf;
+  // Buffer that compresses repeating sequences of tags into loops, if SIGHT_LOOP_COMPRESS is set
+  loopCompressBuf* loopBuf;
   // Buffer for the above stream
   dbgBuf* buf;
   // Holds any text printed out before the dbgStream is fully initialized
@@ -940,6 +1592,18 @@ public:
   void init(properties* props, std::string title, std::string workDir, std::string imgDir, std::string tmpDir);
   ~dbgStream();
   
+  private:
+  // Connects this stream to the node's aggregator process, launching it if this process is the node's first
+  void initNodeAggregation();
+  
+  // Connects this stream to an slayout process that reads its structure from a shared memory ring
+  void initShmLayout();
+  
+  // Connects this stream to the given ring, handling the ring overflowing according to SIGHT_RING_OVERFLOW
+  void initRingOutput(shmRing* ring);
+  
+  public:
+  
   // Switch between the owner class and user code writing text into this stream
   void userAccessing();
   void ownerAccessing();
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <streambuf>
+
+namespace sight {
+
+/* #################### DESIGN NOTES ####################
+Iterative applications emit nearly identical sequences of tags on every iteration (e.g. the same
+scope/traceAttr/module tags on every timestep), differing only in a few property values such as
+IDs, clocks and observed values. When SIGHT_LOOP_COMPRESS is set, the structure output is passed
+through a loopCompressBuf, which detects such repetitions online and replaces them with a loop
+template and a short per-iteration parameter vector. Iterations of outer loops often contain inner loops
+with varying trip counts, so loopCompressBuf is applied at several levels: each level compresses the
+output of the previous one, including its loop tags.
+
+The structure stream is split into records: each tag ([...] or [/...]) and each run of text between
+tags. Each record is in turn split into literal segments and parameters. The parameters of a tag are
+the values of its properties and the parameter of a text run is the text itself. Records with the
+same segments have the same shape. When the last 2P records consist of two repetitions of the same
+sequence of P shapes, the parameters that are the same in both repetitions are folded into the
+template's literal text and the rest become the loop's parameters. The template and each iteration
+are written out as
+  [loopTemplate numProperties="2" name0="ID" val0="..." name1="body" val1="..."]
+  [loopIter numProperties="2" name0="params" val0="..." name1="tmpl" val1="..."]
+where body holds the template's literal segments and params the iteration's parameters, encoded
+and separated as described in tag_loops.C. Unlike other tags, the values of loop tags are not escaped.
+Subsequent iterations that match the template's shapes and constant parameters are emitted as 
+further loopIter tags until one does not match. Template IDs are unique across all levels.
+
+Loop tags have no exit tags. Structure parsers expand them via loopExpander as they read them,
+splicing the text each iteration encodes back into the input, so slayout, hier_merge and all other
+tools see exactly the tags that were originally emitted.
+############################################################ */
+
+// A record of the structure output, split into its literal segments and the parameters between them.
+// The record's text is segs[0] + params[0] + segs[1] + ... + params[n-1] + segs[n].
+class loopRecord {
+  public:
+  std::vector<std::string> segs;
+  std::vector<std::string> params;
+  // Hash of segs, which identifies the record's shape
+  size_t shapeHash;
+  // The number of bytes of the record's text
+  size_t bytes;
+
+  // Splits the given tag or text record into segments and parameters
+  loopRecord(const std::string& text, bool isTag);
+
+  bool sameShape(const loopRecord& that) const { return shapeHash==that.shapeHash && segs==that.segs; }
+
+  // Returns the record's text
+  std::string str() const;
+}; // class loopRecord
+
+// Stream buffer that compresses repeating sequences of tags in the structure written through it
+// into loop templates and iterations before writing it to baseBuf
+class loopCompressBuf : public std::streambuf {
+  std::streambuf* baseBuf;
+  
+  // The next level of compression, which this level writes into, or NULL if this is the last level
+  loopCompressBuf* outer;
+  
+  // The IDs of the templates of this level are idOffset, idOffset+idStride, idOffset+2*idStride, ...
+  int idOffset;
+  int idStride;
+
+  // The maximum number of records in a loop iteration
+  int maxPeriod;
+
+  // The record currently being read and whether it is a tag
+  std::string cur;
+  bool inTag;
+
+  // Records that have been read but not yet written out, which are candidates for the start of a loop.
+  // At most 2*maxPeriod records are kept.
+  std::deque<loopRecord> pending;
+
+  // For each period P, the number of consecutive most recent records that have the same shape as the
+  // record P positions before them. A loop with period P is found when runs[P] reaches P.
+  std::vector<int> runs;
+
+  // For each period P, the number of records that must be read before we again try to start a loop with
+  // period P, which lets us avoid re-checking repetitions that are not worth compressing
+  std::vector<long> retryAt;
+  long numRecords;
+
+  // The loop template currently being matched, if any
+  class loopTemplate {
+    public:
+    int ID;
+    // The shapes of the records in an iteration
+    std::vector<loopRecord> shapes;
+    // For each record, records whether each of its parameters varies across iterations
+    std::vector<std::vector<bool> > isParam;
+  };
+  loopTemplate* active;
+  // The records of the active loop's current iteration read so far
+  std::vector<loopRecord> iter;
+
+  // Maps the body of each template emitted so far to its ID
+  std::map<std::string, int> templateIDs;
+
+  // The number of bytes read and written and the number of loop iterations emitted
+  long long bytesIn;
+  long long bytesOut;
+  long numIters;
+
+  public:
+  loopCompressBuf(std::streambuf* baseBuf, int maxPeriod=64, int levels=2);
+  
+  protected:
+  loopCompressBuf(std::streambuf* baseBuf, int maxPeriod, int levels, int idOffset, int idStride);
+  void init(int levels);
+  
+  public:
+  ~loopCompressBuf();
+
+  // Writes out all the records that are being held back while looking for loops
+  void flush();
+
+  // Returns a summary of the compression achieved so far
+  std::string str() const;
+
+  protected:
+  virtual int_type overflow(int_type c);
+  virtual std::streamsize xsputn(const char* s, std::streamsize num);
+  // Syncing does not flush the pending records, since applications sync after every line of text
+  virtual int sync();
+
+  // Appends the given character to the current record, completing it if needed
+  void addChar(char c);
+
+  // Completes the current record
+  void endRecord();
+
+  // Processes a newly completed record
+  void addRecord(const loopRecord& rec);
+
+  // Adds the given record to pending, looking for a loop that ends at it
+  void detect(const loopRecord& rec);
+
+  // Tries to start a loop with the given period from the last 2*period pending records. Returns whether
+  // the loop was started.
+  bool startLoop(int period);
+
+  // Returns whether the given record matches the active template at position pos of its iteration
+  bool matches(const loopRecord& rec, int pos) const;
+
+  // Returns the text of the loopIter tag that encodes the given iteration of the given template
+  std::string iterStr(const loopTemplate& t, const std::vector<loopRecord>& recs) const;
+
+  // Ends the active loop, passing the records of its incomplete iteration back to detection
+  void endLoop();
+
+  // Writes the given text to the next level or baseBuf
+  void write(const std::string& s);
+}; // class loopCompressBuf
+
+// Expands the loop tags written by loopCompressBuf back into the tags they encode
+class loopExpander {
+  // Maps the ID of each template read so far to its literal segments
+  std::map<int, std::vector<std::string> > templates;
+
+  public:
+  // Returns whether tags with the given name are loop tags that must be expanded rather than processed
+  static bool isLoopTag(const std::string& name) { return name=="loopTemplate" || name=="loopIter"; }
+
+  // Processes the loop tag with the given name and properties, setting expansion to the text it encodes
+  void process(const std::string& name, const std::map<std::string, std::string>& pMap, std::string& expansion);
+  
+  // Returns the literal segments of the templates read so far and adds a template that was read elsewhere,
+  // which lets parsing resume in the middle of the input after the templates it refers to
+  const std::map<int, std::vector<std::string> >& getTemplates() const { return templates; }
+  void addTemplate(int ID, const std::vector<std::string>& segs) { templates[ID] = segs; }
+}; // class loopExpander
+
+} // namespace sight
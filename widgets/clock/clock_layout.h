@@ -20,5 +20,51 @@ class clockLayoutHandlerInstantiator  : layoutHandlerInstantiator{
 };
 extern clockLayoutHandlerInstantiator clockLayoutHandlerInstance;
 
+// Reconstructs the current values of the application's clocks from the clock records in the log. 
+// Each record holds the change in a clock's value since its previous record on the same stream. Each variant 
+// of the log starts from the state of its parent stream at the point where the variants were entered and once 
+// all the variants complete, the parent resumes from the latest state reached by any of them, mirroring the 
+// way hier_merge encodes the records.
+class clockState {
+  // The current time, in microseconds, or -1 if no timeClock record has been read
+  long long curTime;
+  
+  // Maps the IDs of the stepClocks to their current steps
+  std::map<int, std::vector<long> > curSteps;
+  
+  // The latest state reached by any of the variants of this stream that have completed so far, 
+  // which this stream resumes from once the last variant completes
+  long long resumeTime;
+  std::map<int, std::vector<long> > resumeSteps;
+  
+  // The state of each stream being laid out, with the innermost variant at the back
+  static std::list<clockState> streams;
+  
+  clockState() : curTime(-1), resumeTime(-1) {}
+  
+  // Returns the state of the stream currently being laid out
+  static clockState& cur();
+  
+  public:
+  // Called before each variant is laid out
+  static void enterVariant();
+  
+  // Called after each variant is laid out
+  static void exitVariant(bool lastVariant);
+  
+  // Applies a timeClock record to the current time
+  static void* timeClockEnterHandler(properties::iterator props);
+  
+  // Applies a stepClock record to the current step of its clock
+  static void* stepClockEnterHandler(properties::iterator props);
+  
+  // Returns the current time in seconds or a negative value if it is not known
+  static double getTime() { return (cur().curTime<0? -1: cur().curTime/1000000.0); }
+  
+  // Returns the current step of the given stepClock or NULL if it is not known
+  static const std::vector<long>* getStep(int stepClockID)
+  { return (cur().curSteps.find(stepClockID)==cur().curSteps.end()? NULL: &cur().curSteps[stepClockID]); }
+}; // class clockState
+
 }; // namespace layout
 }; // namespace sight
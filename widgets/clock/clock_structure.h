@@ -17,7 +17,8 @@
 namespace sight {
 namespace structure {
 
-// A clock based on the current system time
+// A clock based on the current system time. Its records hold the absolute time in microseconds (key usec) 
+// the first time the clock is emitted and the number of microseconds since the previous record (key dt) after that.
 class timeClock: public sightClock {
   private:
   struct timeval curTime;
@@ -26,6 +27,14 @@ class timeClock: public sightClock {
   // correspond to the same real clock, we register the clock once for all currently active instances of timeClock.
   static std::set<timeClock*> active;
   
+  // The time, in microseconds, that was emitted in the most recent record of this clock or -1 if none was emitted.
+  // This is shared by all instances since they all correspond to the same real clock.
+  static long long lastEmitted;
+  
+  // The minimum number of microseconds that must pass before the clock is considered to be modified. 
+  // Set via environment variable SIGHT_TIME_CLOCK_RESOLUTION, defaulting to 1 millisecond.
+  static long resolution;
+  
   timeClock();
   
   ~timeClock();
@@ -40,7 +49,8 @@ class timeClock: public sightClock {
 
 
 // A clock to mark the application's progress through discrete steps of application execution, such as program phases
-// or iterations of a loop nest.
+// or iterations of a loop nest. Its records hold the clock's ID, its number of dimensions if this is the first 
+// record of the clock and the values of only the dimensions that changed since the previous record (keys dim<i>).
 class stepClock: public sightClock {
   private:
   // This stepClock's uniqueID
@@ -49,6 +59,9 @@ class stepClock: public sightClock {
   
   // The current step of this clock
   std::vector<int> curStep;
+  
+  // The step that was emitted in the most recent record of this clock, which is empty if none was emitted
+  std::vector<int> lastEmitted;
     
   // Records whether this clock has been modified since its creation or the last time modified() was called;
   bool isModified;
@@ -104,11 +117,12 @@ class ClockMergeHandlerInstantiator: public MergeHandlerInstantiator {
 };
 extern ClockMergeHandlerInstantiator ClockMergeHandlerInstance;
 
-std::map<std::string, streamRecord*> ClockGetMergeStreamRecord(int streamID);
+std::map<std::string, streamRecord*> TimeClockGetMergeStreamRecord(int streamID);
 
 std::map<std::string, streamRecord*> StepClockGetMergeStreamRecord(int streamID);
 
-// Merger for timeClock tag
+// Merger for timeClock tag. Since timeClock records are emitted at points that depend on the timing of the 
+// application, hier_merge consumes them out of band via consume() and emit() rather than aligning them.
 class TimeClockMerger : public Merger {
   public:
   TimeClockMerger(std::vector<std::pair<properties::tagType, properties::iterator> > tags,
@@ -134,6 +148,16 @@ class TimeClockMerger : public Merger {
   // call their parents so they can add any info. Keys from base classes must precede keys from derived classes.
   static void mergeKey(properties::tagType type, properties::iterator tag, 
                        std::map<std::string, streamRecord*>& inStreamRecords, std::list<std::string>& key);
+  
+  // Records the time encoded by a timeClock record that was read out of band on the given incoming stream
+  static void consume(properties::tagType type, properties::iterator tag, 
+                      std::map<std::string, streamRecord*>& inStreamRecords);
+  
+  // If the latest time recorded on the given group of incoming streams has advanced past the time last emitted
+  // on the outgoing stream, adds to tags a timeClock record of this time
+  static void emit(std::map<std::string, streamRecord*>& outStreamRecords,
+                   std::vector<std::map<std::string, streamRecord*> >& inStreamRecords,
+                   std::list<std::pair<properties::tagType, properties> >& tags);
 }; // class TimeClockMerger
 
 // Merger for stepClock tag
@@ -164,21 +188,65 @@ class StepClockMerger : public Merger {
                        std::map<std::string, streamRecord*>& inStreamRecords, std::list<std::string>& key);
 }; // class StepClockMerger
 
+// Records the time of the most recent timeClock record on a given stream so that the absolute 
+// times encoded by subsequent delta records can be reconstructed
+class TimeClockStreamRecord: public streamRecord {
+  friend class TimeClockMerger;
+  
+  // The time, in microseconds, of the most recent timeClock record or -1 if there was none
+  long long lastTime;
+  
+  public:
+  TimeClockStreamRecord(int vID)              : streamRecord(vID, "timeClock"), lastTime(-1) { }
+  TimeClockStreamRecord(const variantID& vID) : streamRecord(vID, "timeClock"), lastTime(-1) { }
+  TimeClockStreamRecord(const TimeClockStreamRecord& that, int vSuffixID) : streamRecord(that, vSuffixID), lastTime(that.lastTime) {}
+  
+  // Returns a dynamically-allocated copy of this streamRecord, specialized to the given variant ID,
+  // which is appended to the new stream's variant list.
+  streamRecord* copy(int vSuffixID) { return new TimeClockStreamRecord(*this, vSuffixID); }
+  
+  // Returns the absolute time, in microseconds, encoded by the given timeClock record on this stream
+  long long getTime(properties::iterator tag) const;
+  
+  // Given multiple streamRecords from several variants of the same outgoing stream, update this streamRecord object
+  // to contain the state that succeeds them all, making it possible to resume processing
+  void resumeFrom(std::vector<std::map<std::string, streamRecord*> >& streams);
+  
+  std::string str(std::string indent="") const {
+    std::ostringstream s;
+    s << "[TimeClockStreamRecord: lastTime="<<lastTime<<" ";
+    s << streamRecord::str(indent+"    ") << "]";
+    return s.str();
+  }
+}; // class TimeClockStreamRecord
+
+// Records the most recent step of each stepClock on a given stream so that the full steps 
+// encoded by subsequent delta records can be reconstructed
 class StepClockStreamRecord: public streamRecord {
   friend class StepClockMerger;
   
+  // Maps the IDs of the stepClocks on this stream to their most recent steps
+  std::map<int, std::vector<long> > steps;
+  
   public:
   StepClockStreamRecord(int vID)              : streamRecord(vID, "stepClock") { }
   StepClockStreamRecord(const variantID& vID) : streamRecord(vID, "stepClock") { }
-  StepClockStreamRecord(const StepClockStreamRecord& that, int vSuffixID) : streamRecord(that, vSuffixID) {}
+  StepClockStreamRecord(const StepClockStreamRecord& that, int vSuffixID) : streamRecord(that, vSuffixID), steps(that.steps) {}
   
   // Returns a dynamically-allocated copy of this streamRecord, specialized to the given variant ID,
   // which is appended to the new stream's variant list.
   streamRecord* copy(int vSuffixID) { return new StepClockStreamRecord(*this, vSuffixID); }
   
+  // Returns the full step encoded by the given stepClock record on this stream
+  std::vector<long> getStep(properties::iterator tag) const;
+  
+  // Given multiple streamRecords from several variants of the same outgoing stream, update this streamRecord object
+  // to contain the state that succeeds them all, making it possible to resume processing
+  void resumeFrom(std::vector<std::map<std::string, streamRecord*> >& streams);
+  
   std::string str(std::string indent="") const {
     std::ostringstream s;
-    s << "[StepClockStreamRecord: ";
+    s << "[StepClockStreamRecord: #steps="<<steps.size()<<" ";
     s << streamRecord::str(indent+"    ") << "]";
     return s.str();
   }
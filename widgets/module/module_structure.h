@@ -13,6 +13,7 @@
 #include "../../sight_structure_internal.h"
 #include "Callpath.h"
 #include <pthread.h>
+#include <signal.h>
 
 namespace sight {
 namespace structure {
@@ -228,6 +229,11 @@ class generateTraceStream {
   virtual traceStream* operator()(int moduleID)=0;
 }; // class generateTraceStream
 
+// The maximum depth of module nesting tracked by the modularApp's sampling profiler
+#define MODULE_SAMPLE_STACK 256
+// The number of frames recorded for the call path of each of the profiler's samples
+#define MODULE_SAMPLE_FRAMES 8
+
 // Represents a modular application, which may contain one or more modules. Only one modular application may be
 // in-scope at any given point in time.
 class modularApp: public block
@@ -275,6 +281,70 @@ class modularApp: public block
   // Stack of the modules that are currently in scope
   static std::list<module*> mStack;
   
+  // ----------------------------------
+  // ----- Statistical profiling -----
+  // ----------------------------------
+  // When the SIGHT_MODULE_SAMPLE_HZ environment variable is set to a positive rate, the execution of the application 
+  // is sampled at this rate via SIGPROF while a modularApp is active. Each sample is attributed to the module on top 
+  // of mStack. Each module instance adds to its moduleTraceStream observation the number of samples taken while it 
+  // was at the top of the stack (measure:samples:self), while it was anywhere on the stack (measure:samples:total) 
+  // and the call path sampled most often while it was at the top of the stack (measure:samples:hotPath).
+  // Since the signal handler cannot safely read mStack, the IDs of the module groups on mStack are mirrored in 
+  // sampleStack, which is updated in a way that keeps it consistent at every point where a signal may arrive.
+  // Call paths are recorded by walking the frame pointers of the interrupted thread, which is async-signal-safe 
+  // unlike backtrace(). They are complete only for code compiled with frame pointers and only include the
+  // innermost frame of samples taken on threads other than the one that started the modularApp.
+  
+  // The sampling rate, or 0 if sampling is disabled
+  static int sampleHz;
+  
+  // The IDs of the module groups on mStack and the number of them
+  static volatile int sampleStack[MODULE_SAMPLE_STACK];
+  static volatile sig_atomic_t sampleStackDepth;
+  
+  // The number of samples attributed to each entry of sampleStack while it was at the top of the stack
+  static volatile long sampleSelf[MODULE_SAMPLE_STACK];
+  
+  // The total number of samples taken so far
+  static volatile long sampleTotal;
+  
+  // A single sample: the module group it was attributed to (-1 if none) and the call path where it was taken
+  typedef struct {
+    int moduleID;
+    int numFrames;
+    void* frames[MODULE_SAMPLE_FRAMES];
+  } sampleRecord;
+  
+  // Buffer of the samples' call paths. Whenever a module is entered the samples of the module instance that 
+  // encloses it are folded into that instance's path counts and removed from the buffer, and when an instance exits
+  // its own samples are removed, so the buffer only holds the samples taken since the last module entry or exit. 
+  // Once it fills up further samples are counted but their call paths are dropped, which is reported once.
+  static sampleRecord* samples;
+  static volatile long numSamples;
+  static long maxSamples;
+  static bool warnedSamplesFull;
+  
+  // The bounds of the stack of the thread that started sampling, within which frame pointers are followed
+  static char* sampleStackLo;
+  static char* sampleStackHi;
+  
+  // The SIGPROF action that was installed before sampling started, which is restored when it stops
+  static struct sigaction prevSampleAction;
+  
+  // SIGPROF handler that records a single sample
+  static void sampleHandler(int /*sig*/, siginfo_t* /*info*/, void* context);
+  
+  // Starts and stops sampling
+  static void startSampling();
+  static void stopSampling();
+  
+  // Adds the samples recorded since module instance m was entered that were attributed to its group to its path 
+  // counts and removes them from the buffer
+  static void foldSamples(module* m);
+  
+  // Returns the call path sampled most often according to the given path counts, or "" if there are none
+  static std::string hotPath(const std::map<std::vector<void*>, long>& pathCounts);
+  
   public:
   static const std::list<module*>& getMStack() { return mStack; }
   
@@ -416,6 +486,14 @@ class module: public sightObj, public common::module
   // that class to create an appropriate traceStream.
   bool isDerived;
   
+  // The values of modularApp::sampleTotal and modularApp::numSamples when this module instance was entered
+  long samplesAtEntry;
+  long pathsAtEntry;
+  
+  // The number of samples of each call path taken while this module instance was at the top of the stack
+  // that have been folded out of modularApp's buffer so far
+  std::map<std::vector<void*>, long> pathCounts;
+  
   public:
   // inputs - ports from other modules that are used as inputs by this module.
   // onoffOp - We emit this scope if the current attribute query evaluates to true (i.e. we're emitting debug output) AND
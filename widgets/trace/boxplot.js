@@ -3,11 +3,6 @@ function showBoxPlot(vizData, targetDiv, keyName, valName, width, height, margin
   var min = Infinity,
       max = -Infinity;
 
-  var chart = d3.box()
-      .whiskers(iqr(1.5))
-      .width(width)
-      .height(height);
-
 //d3.csv("file:///tmp/bronevet/compile/projects/fuse/src/dbg/html/morley.csv", function(error, csv) {
     var data = [];
     // Maps names of keys to their numeric indexes within the data array
@@ -47,10 +42,41 @@ function showBoxPlot(vizData, targetDiv, keyName, valName, width, height, margin
       console.log("    "+name+": "+data[key2Idx[name]].length+" ["+key2Min[name].toExponential()+", "+key2Max[name].toExponential()+"] \in ["+min.toExponential()+", "+max.toExponential()+"]");
     }*/
 
+    var names = [];
+    for(var name in key2Idx) names.push(name);
+    
+    drawBoxPlots(data, names, min, max, targetDiv, width, height, margin);
+}
+
+// Shows boxplots of observations that were summarized by slayout.
+// summaries: [{name:ctxtVal, summary:{n:, min:, max:, mean:, quartiles:[q1, q2, q3], whiskers:[lo, hi], outliers:[...]}}, ...]
+function showBoxPlotSummaries(summaries, targetDiv, width, height, margin) {
+  var min = Infinity,
+      max = -Infinity;
+  
+  var data = [], names = [];
+  summaries.forEach(function(x) {
+    data.push(x.summary);
+    names.push(x.name);
+    max = Math.max(x.summary.max, max);
+    min = Math.min(x.summary.min, min);
+  });
+  
+  drawBoxPlots(data, names, min, max, targetDiv, width, height, margin);
+}
+
+// Draws one boxplot for each element of data, which is either an array of observations or a summary 
+// of the observations computed by slayout, labeled with the corresponding element of names
+function drawBoxPlots(data, names, min, max, targetDiv, width, height, margin) {
+  var chart = d3.box()
+      .whiskers(iqr(1.5))
+      .width(width)
+      .height(height);
+
     var boxData = [];
     var loc=0;
-    for(var name in key2Idx) {
-      boxData.push({"name":name, "loc":loc});
+    for(var i=0; i<names.length; i++) {
+      boxData.push({"name":names[i], "loc":loc});
       loc += width + margin.left + margin.right;
     }
 
@@ -155,24 +181,39 @@ d3.box = function() {
   // For each small multiple.
   function box(g) {
     g.each(function(d, i) {
-      d = d.map(value).sort(d3.ascending);
       var g = d3.select(this),
-          n = d.length,
-          min = d[0],
-          max = d[n - 1];
+          n, min, max, quartileData, whiskerData, outlierIndices;
+      
+      // If the observations were summarized by slayout, the quartiles, whiskers and outliers are already known
+      if(!(d instanceof Array)) {
+        var summary = d;
+        // The outliers are the only individual observations we have
+        d = summary.outliers.slice().sort(d3.ascending);
+        n = summary.n;
+        min = summary.min;
+        max = summary.max;
+        quartileData = d.quartiles = summary.quartiles;
+        whiskerData = summary.whiskers;
+        outlierIndices = d3.range(d.length);
+      } else {
+      d = d.map(value).sort(d3.ascending);
+      n = d.length;
+      min = d[0];
+      max = d[n - 1];
 
       // Compute quartiles. Must return exactly 3 elements.
-      var quartileData = d.quartiles = quartiles(d);
+      quartileData = d.quartiles = quartiles(d);
 
       // Compute whiskers. Must return exactly 2 elements, or null.
-      var whiskerIndices = whiskers && whiskers.call(this, d, i),
-          whiskerData = whiskerIndices && whiskerIndices.map(function(i) { return d[i]; });
+      var whiskerIndices = whiskers && whiskers.call(this, d, i);
+      whiskerData = whiskerIndices && whiskerIndices.map(function(i) { return d[i]; });
 
       // Compute outliers. If no whiskers are specified, all data are "outliers".
       // We compute the outliers as indices, so that we can join across transitions!
-      var outlierIndices = whiskerIndices
+      outlierIndices = whiskerIndices
           ? d3.range(0, whiskerIndices[0]).concat(d3.range(whiskerIndices[1] + 1, n))
           : d3.range(n);
+      }
 
       // Compute the new x-scale.
       var x1 = d3.scale.linear()
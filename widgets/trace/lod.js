@@ -0,0 +1,205 @@
+// Level-of-detail support for traces that have too many observations to show individually.
+// For such traces slayout emits a pyramid of progressively finer summaries. The coarsest level
+// is included in the page and the finer levels are stored in separate files that are loaded
+// on demand as the user zooms into a region of the visualization.
+
+// Maps each traceLabel to the list of its lines series, each of which is a hash with keys
+// ctxtKey, traceKey, minX, maxX, dir and tiles, where tiles maps "level_tile" to the tile's data
+var traceLODSeriesList = {};
+
+// Records a single series of a lines trace
+function traceLODSeries(traceLabel, seriesIdx, ctxtKey, traceKey, minX, maxX, dir) {
+  if(!(traceLabel in traceLODSeriesList)) traceLODSeriesList[traceLabel] = [];
+  traceLODSeriesList[traceLabel][seriesIdx] = {ctxtKey: ctxtKey, traceKey: traceKey, minX: minX, maxX: maxX, dir: dir, tiles: {}};
+}
+
+// Records a single tile of a lines series. children is a bit mask that identifies which of the tile's
+// two sub-tiles exist and is 0 if the tile holds all of the points in its range.
+function traceLODTile(traceLabel, seriesIdx, level, tile, children, points) {
+  traceLODSeriesList[traceLabel][seriesIdx].tiles[level+"_"+tile] = {children: children, points: points};
+}
+
+// Returns whether the given trace is shown via level-of-detail pyramids
+function hasTraceLOD(traceLabel) {
+  return (traceLabel in traceLODSeriesList) || (traceLabel in traceOctrees);
+}
+
+// Maps the IDs of the host divs of level-of-detail lines plots to the x-range currently shown in them
+var traceLODRange = {};
+
+// Shows the level-of-detail lines plot of the given trace's series with the given context and trace keys,
+// restricted to x-range [lo, hi]. If lo and hi are undefined, the full range is shown.
+function showLinesLOD(traceLabel, ctxtKey, traceAttrs, hostDivID, lo, hi) {
+  var series = [];
+  var minX=1e100, maxX=-1e100;
+  for(var s in traceLODSeriesList[traceLabel]) { if(traceLODSeriesList[traceLabel].hasOwnProperty(s)) {
+    var cur = traceLODSeriesList[traceLabel][s];
+    if(cur.ctxtKey != ctxtKey || traceAttrs.indexOf(cur.traceKey)<0) continue;
+    series.push(s);
+    if(cur.minX < minX) minX = cur.minX;
+    if(cur.maxX > maxX) maxX = cur.maxX;
+  } }
+
+  if(lo === undefined || hi === undefined) { lo = minX; hi = maxX; }
+  traceLODRange[hostDivID] = [lo, hi];
+
+  // Collect the points of all the series, loading any tiles that are not yet available
+  var data = [];
+  var pending = 0;
+  for(var i in series) { if(series.hasOwnProperty(i)) {
+    var cur = traceLODSeriesList[traceLabel][series[i]];
+    // The finest level of detail needed to show range [lo, hi] at the resolution of the root tile
+    var level = (hi>lo? Math.max(0, Math.floor(Math.log((cur.maxX - cur.minX) / (hi - lo)) / Math.LN2)): 0);
+    pending += collectLODTile(traceLabel, series[i], 0, 0, cur.minX, cur.maxX + (cur.maxX-cur.minX)*1e-9 + 1e-300,
+                              lo, hi, level, data,
+                              function() {
+                                // Re-draw the plot once the missing tiles arrive, unless the user has moved on
+                                if(traceLODRange[hostDivID][0]==lo && traceLODRange[hostDivID][1]==hi)
+                                  showLinesLOD(traceLabel, ctxtKey, traceAttrs, hostDivID, lo, hi);
+                              });
+  } }
+
+  var plot = showScatterplot(data, hostDivID, "lin", "lin");
+
+  // Let users zoom into the plot by brushing a range of x values and zoom out by double-clicking
+  var brush = d3.svg.brush()
+                .x(plot.x)
+                .on("brushend", function() {
+                  if(brush.empty()) return;
+                  var ext = brush.extent();
+                  showLinesLOD(traceLabel, ctxtKey, traceAttrs, hostDivID, ext[0], ext[1]);
+                });
+  plot.main.append("g")
+           .attr("class", "x brush")
+           .call(brush)
+           .selectAll("rect")
+               .attr("height", plot.height)
+               .style({"fill": "#69f", "fill-opacity": ".3"});
+  plot.main.on("dblclick", function() { showLinesLOD(traceLabel, ctxtKey, traceAttrs, hostDivID); });
+}
+
+// Adds to data the points of the given tile, which spans x-range [tileLo, tileHi), or its descendants that fall
+// within range [lo, hi], descending no further than targetLevel. Tiles that are not yet loaded are requested
+// and continuationFunc is called once each one arrives. Returns the number of such pending tiles.
+function collectLODTile(traceLabel, seriesIdx, level, tile, tileLo, tileHi, lo, hi, targetLevel, data, continuationFunc) {
+  if(tileHi < lo || tileLo > hi) return 0;
+
+  var series = traceLODSeriesList[traceLabel][seriesIdx];
+  var cur = series.tiles[level+"_"+tile];
+  if(cur === undefined) {
+    loadjscssfile(series.dir+"/t"+traceLabel+"_"+seriesIdx+"_"+level+"_"+tile+".js", "text/javascript", continuationFunc);
+    return 1;
+  }
+
+  // If this is a leaf or we've reached the target level, add the tile's points
+  if(cur.children==0 || level>=targetLevel) {
+    for(var p in cur.points) { if(cur.points.hasOwnProperty(p)) {
+      if(cur.points[p][0]>=lo && cur.points[p][0]<=hi) data.push(cur.points[p]);
+    } }
+    return 0;
+  }
+
+  var pending=0;
+  var mid = (tileLo+tileHi)/2;
+  if(cur.children & 1) pending += collectLODTile(traceLabel, seriesIdx, level+1, tile*2,   tileLo, mid,    lo, hi, targetLevel, data, continuationFunc);
+  if(cur.children & 2) pending += collectLODTile(traceLabel, seriesIdx, level+1, tile*2+1, mid,    tileHi, lo, hi, targetLevel, data, continuationFunc);
+
+  // While the finer tiles are loading, show the points of this tile to keep the plot populated
+  if(pending>0) {
+    for(var p in cur.points) { if(cur.points.hasOwnProperty(p)) {
+      if(cur.points[p][0]>=lo && cur.points[p][0]<=hi) data.push(cur.points[p]);
+    } }
+  }
+  return pending;
+}
+
+// Maps each traceLabel to the octree of its scatter3d observations: a hash with keys ctxtMin, ctxtMax,
+// colorMin, colorMax, dir and nodes, where nodes maps each node's ID to its data
+var traceOctrees = {};
+
+// Records the bounds of a scatter3d trace's octree
+function traceOctree(traceLabel, ctxtMin, ctxtMax, colorMin, colorMax, dir) {
+  traceOctrees[traceLabel] = {ctxtMin: ctxtMin, ctxtMax: ctxtMax, colorMin: colorMin, colorMax: colorMax, dir: dir, nodes: {}};
+}
+
+// Records a single node of a scatter3d trace's octree. If children is empty, points holds all the
+// observations in the node's bounding box. Otherwise it holds a representative sample of them.
+function traceOctreeNode(traceLabel, nodeID, bbMin, bbMax, children, points) {
+  traceOctrees[traceLabel].nodes[nodeID] = {bbMin: bbMin, bbMax: bbMax, children: children, points: points};
+}
+
+// Shows the level-of-detail 3D scatter plot of the given trace
+function showScatter3DLOD(traceLabel, axisNames, hostDivID) {
+  var tree = traceOctrees[traceLabel];
+  var plot = showScatter3D(tree.nodes["r"].points, axisNames, tree.ctxtMin, tree.ctxtMax, tree.colorMin, tree.colorMax, hostDivID);
+
+  // Maps the IDs of the nodes currently shown to the THREE.Object3D groups that hold their points
+  var shown = {"r": plot.points};
+  // The IDs of the nodes whose children are currently loading
+  var loading = {};
+
+  var initialDist = plot.camera.position.distanceTo(plot.control.target);
+
+  // Refine the nodes that are near the focus of the camera as the user zooms in. Nodes are only ever
+  // refined, so the detail that has been loaded remains visible when the user zooms back out.
+  var refine = function() {
+    var dist = plot.camera.position.distanceTo(plot.control.target);
+    // The octree depth that matches the current zoom level, where the root is shown at depth 0
+    var depth = Math.floor(Math.log(Math.max(initialDist / dist, 1)) / Math.LN2);
+
+    for(var nodeID in shown) { if(shown.hasOwnProperty(nodeID)) {
+      var node = tree.nodes[nodeID];
+      // Node IDs are the IDs of their parents followed by their octant, so the length of the ID of a
+      // node at depth d is d+1 and it needs to be refined if the current depth is larger than d
+      if(node.children.length==0 || nodeID.length > depth || nodeID in loading) continue;
+
+      // Only refine nodes whose bounding box is within the camera's distance from its focus
+      var center = [], radius=0;
+      for(var i=0; i<3; i++) {
+        var lo = 16 * (node.bbMin[i] - tree.ctxtMin[i]) / plot.sep[i],
+            hi = 16 * (node.bbMax[i] - tree.ctxtMin[i]) / plot.sep[i];
+        center[i] = (lo+hi)/2;
+        radius += (hi-lo)*(hi-lo)/4;
+      }
+      var centerDist = plot.control.target.distanceTo(new THREE.Vector3(center[0], center[1], center[2]));
+      if(centerDist - Math.sqrt(radius) > dist) continue;
+
+      loadOctreeChildren(traceLabel, nodeID, function(nodeID) {
+        // Replace the node's sample with the points of its children
+        plot.scene.remove(shown[nodeID]);
+        delete shown[nodeID];
+        delete loading[nodeID];
+        var children = tree.nodes[nodeID].children;
+        for(var c in children) { if(children.hasOwnProperty(c)) {
+          var group = new THREE.Object3D();
+          addScatter3DPoints(group, tree.nodes[children[c]].points, tree.ctxtMin, plot.sep, tree.colorMin, tree.colorMax, plot.colors);
+          plot.scene.add(group);
+          shown[children[c]] = group;
+        } }
+        refine();
+      });
+      loading[nodeID] = 1;
+    } }
+  };
+
+  // Refine the octree once the camera has settled
+  var timer;
+  plot.control.addEventListener('change', function() { clearTimeout(timer); timer = setTimeout(refine, 200); });
+}
+
+// Loads all the children of the given octree node and calls continuationFunc(nodeID) once they're all available
+function loadOctreeChildren(traceLabel, nodeID, continuationFunc) {
+  var tree = traceOctrees[traceLabel];
+  var children = tree.nodes[nodeID].children;
+  var pending = 0;
+  var onLoad = function() { if(--pending == 0) continuationFunc(nodeID); };
+  for(var c in children) { if(children.hasOwnProperty(c)) {
+    if(!(children[c] in tree.nodes)) pending++;
+  } }
+  if(pending==0) { continuationFunc(nodeID); return; }
+
+  for(var c in children) { if(children.hasOwnProperty(c)) {
+    if(!(children[c] in tree.nodes))
+      loadjscssfile(tree.dir+"/t"+traceLabel+"_o"+children[c]+".js", "text/javascript", onLoad);
+  } }
+}
@@ -135,4 +135,7 @@ function showScatterplot(data, hostDivID, xAxisType, yAxisType) {
            .attr("cy", function (d) { return y[1](parseFloat(d[1])); } )
            .attr("r", 3)
            .style("fill", "red"/*function(d,i) { return colors[i]; }*/ );
+  
+  // Return the plot's scales and drawing area to make it possible for callers to add interactions to it
+  return {x: x[1], y: y[1], xAxisType: xAxisType, yAxisType: yAxisType, main: main, width: width, height: height};
 }
@@ -117,9 +117,37 @@ function showScatter3D(data, axisNames, ctxtMin, ctxtMax, colorAttrMin, colorAtt
   
   // Identify the minimum separation between adjacent context values in each dimension
   var sep = ctxtSep(data, ctxtMin, ctxtMax);
+  
+  // All the points are placed in a single group to make it possible to replace them later
+  var points = new THREE.Object3D();
+  scene.add(points);
+  var maxCoord = addScatter3DPoints(points, data, ctxtMin, sep, colorAttrMin, colorAttrMax, colors);
+  var maxAllCoords = -1e100; // The maximum value among all values along all coordinates
+  for(var i=0; i<3; i++) maxAllCoords = (maxCoord[i] > maxAllCoords? maxCoord[i]: maxAllCoords);
+  
+  // create a set of coordinate axes to help orient user
+  //    specify length in pixels in each direction
+  var axes = new THREE.AxisHelper(maxAllCoords);
+  scene.add( axes );
+  
+  axisLabel(scene, axes, 160+maxCoord[0], -20,         0,              axisNames[0]);
+  axisLabel(scene, axes, 130,             maxCoord[1], 0,              axisNames[1]);
+  axisLabel(scene, axes, 130,             -20,         10+maxCoord[2], axisNames[2]);
+  
+  // fog must be added to scene before first render
+  scene.fog = new THREE.FogExp2( 0x9999ff, 0.00025 );
+
+  animate();
+  
+  return {scene: scene, camera: camera, control: control, points: points, sep: sep, colors: colors};
+}
+
+// Adds a sphere for each observation in data to the given THREE.Object3D group, positioning 
+// it according to ctxtMin and sep and coloring it according to its 4th coordinate.
+// Returns the maximum position of any sphere along each coordinate.
+function addScatter3DPoints(group, data, ctxtMin, sep, colorAttrMin, colorAttrMax, colors) {
   var maxCoord = []; // Array that keeps track of the maximum value taken by any coordinate
   for(var i=0; i<3; i++) maxCoord[i] = -1e100;
-  var maxAllCoords = -1e100; // The maximum value among all values along all coordinates
   
   for(d in data) { if(data.hasOwnProperty(d)) {
     var sphereGeometry = new THREE.SphereGeometry( 3, 8, 8);
@@ -141,13 +169,11 @@ function showScatter3D(data, axisNames, ctxtMin, ctxtMax, colorAttrMin, colorAtt
     sphere.position.set(pos[0], pos[1], pos[2]);
 
     // Update maxCoord
-    for(var i=0; i<3; i++) {
+    for(var i=0; i<3; i++)
     	maxCoord[i] = (pos[i] > maxCoord[i]? pos[i] : maxCoord[i]);
-    	maxAllCoords = (maxCoord[i] > maxAllCoords? maxCoord[i]: maxAllCoords);
-    }
 
-    // Add the sphere to the scene
-    scene.add(sphere);
+    // Add the sphere to the group
+    group.add(sphere);
 
     // If there are additional trace dimensions, add a vector represent them
     if(data[d].length>4) {
@@ -160,23 +186,11 @@ function showScatter3D(data, axisNames, ctxtMin, ctxtMax, colorAttrMin, colorAtt
                                          data[d].length>6? data[d][6]: 0);
       //var direction = new THREE.Vector3().subVectors(terminus, origin).normalize();
       var arrow = new THREE.ArrowHelper(direction, origin, 50, 0x884400);
-      scene.add(arrow);
+      group.add(arrow);
     }
   } }
   
-  // create a set of coordinate axes to help orient user
-  //    specify length in pixels in each direction
-  var axes = new THREE.AxisHelper(maxAllCoords);
-  scene.add( axes );
-  
-  axisLabel(scene, axes, 160+maxCoord[0], -20,         0,              axisNames[0]);
-  axisLabel(scene, axes, 130,             maxCoord[1], 0,              axisNames[1]);
-  axisLabel(scene, axes, 130,             -20,         10+maxCoord[2], axisNames[2]);
-  
-  // fog must be added to scene before first render
-  scene.fog = new THREE.FogExp2( 0x9999ff, 0.00025 );
-
-  animate();
+  return maxCoord;
 }
 
 function animate() 
@@ -104,6 +104,124 @@ function traceRecord(traceLabel, traceVals, traceValLinks, contextVals, viz) {
   addDataHash(traceLinkHash[traceLabel], traceValLinks, contextVals);
 }
 
+// Maps each trace to a multi-level hash (same format as traceDataHash) that maps each context to the 
+// sketches of the trace attributes observed in that context: {traceKey: {n:, bins:[[lo, hi, count], ...]}, ...}
+var traceSketchHash = {};
+
+// Records a context of a trace that was summarized by slayout rather than emitted as individual observations.
+// traceVals contains the aggregate value of each trace attribute in this context, which is treated as a regular 
+// observation, while traceSketches contains the summaries of the distributions of these values.
+function traceSketchRecord(traceLabel, traceVals, traceValLinks, contextVals, traceSketches, viz) {
+  traceRecord(traceLabel, traceVals, traceValLinks, contextVals, viz);
+  
+  if(!traceSketchHash.hasOwnProperty(traceLabel)) traceSketchHash[traceLabel] = {};
+  addDataHash(traceSketchHash[traceLabel], traceSketches, contextVals);
+}
+
+// Maps each trace to the boxplot summaries of its observations, grouped by context key, trace key and 
+// the value of the context key: traceBoxplotSummaries[traceLabel][ctxtKey][traceKey] = [{name:ctxtVal, summary:{...}}, ...].
+// Observations of traces with no context attributes are recorded under the empty ctxtKey.
+var traceBoxplotSummaries = {};
+
+// Records the summaries of the values of each trace attribute over all the observations where the 
+// context attribute ctxtKey has value ctxtVal. Each summary has the format 
+// {n:, min:, max:, mean:, quartiles:[q1, q2, q3], whiskers:[lo, hi], outliers:[...]}
+function traceBoxplotSummary(traceLabel, ctxtKey, ctxtVal, traceSummaries) {
+  if(!traceBoxplotSummaries.hasOwnProperty(traceLabel)) traceBoxplotSummaries[traceLabel] = {};
+  if(!traceBoxplotSummaries[traceLabel].hasOwnProperty(ctxtKey)) traceBoxplotSummaries[traceLabel][ctxtKey] = {};
+  
+  for(traceKey in traceSummaries) { if(traceSummaries.hasOwnProperty(traceKey)) {
+    if(!traceBoxplotSummaries[traceLabel][ctxtKey].hasOwnProperty(traceKey)) traceBoxplotSummaries[traceLabel][ctxtKey][traceKey] = [];
+    traceBoxplotSummaries[traceLabel][ctxtKey][traceKey].push({name:ctxtVal, summary:traceSummaries[traceKey]});
+  } }
+}
+
+// Returns the boxplot summaries of the given trace, context key and trace key or undefined if the trace's
+// observations were not summarized
+function getBoxplotSummaries(traceLabel, ctxtKey, traceKey) {
+  if(traceBoxplotSummaries.hasOwnProperty(traceLabel) &&
+     traceBoxplotSummaries[traceLabel].hasOwnProperty(ctxtKey) &&
+     traceBoxplotSummaries[traceLabel][ctxtKey].hasOwnProperty(traceKey))
+    return traceBoxplotSummaries[traceLabel][ctxtKey][traceKey];
+  return undefined;
+}
+
+// Maps each trace whose observations were emitted as binary columns to its columns: 
+// {n:numObs, ctxt:{ctxtKey:typedArray, ...}, trace:{traceKey:typedArray, ...}}. Missing values are NaN.
+var traceColumnData = {};
+// Maps each trace whose columns are still loading to the arguments of the displayTrace() calls waiting for them
+var traceColumnWaiting = {};
+
+// Records a trace whose n observations are stored as binary columns in the file at url, which are loaded 
+// in a single request. columns lists the columns in the file as [kind, key, type, offset] where kind is 
+// "ctxt" or "trace", type is "i32" or "f64" and offset is the column's byte offset in the file.
+function traceColumns(traceLabel, url, n, columns, viz) {
+  traceColumnWaiting[traceLabel] = [];
+  loadBinaryFile(url, function(buf) {
+    if(buf == null) { alert("Cannot load the observations of trace "+traceLabel+" from "+url+". Binary trace data can only be loaded when the page is served over HTTP."); return; }
+    
+    if(!minData.hasOwnProperty(traceLabel)) minData[traceLabel] = {};
+    if(!maxData.hasOwnProperty(traceLabel)) maxData[traceLabel] = {};
+    if(ctxtKey2ID[traceLabel] == undefined)  { ctxtKey2ID[traceLabel] = {};  ctxtKeys[traceLabel] = []; }
+    if(traceKey2ID[traceLabel] == undefined) { traceKey2ID[traceLabel] = {}; traceKeys[traceLabel] = []; }
+    
+    var data = {n:n, ctxt:{}, trace:{}};
+    for(var c=0; c<columns.length; c++) {
+      var kind=columns[c][0], key=columns[c][1];
+      var col = (columns[c][2]=="i32"? new Int32Array(buf, columns[c][3], n): new Float64Array(buf, columns[c][3], n));
+      data[kind][key] = col;
+      
+      var minV=1e100, maxV=-1e100;
+      for(var i=0; i<n; i++) {
+        if(col[i] < minV) minV = col[i];
+        if(col[i] > maxV) maxV = col[i];
+      }
+      minData[traceLabel][key] = minV;
+      maxData[traceLabel][key] = maxV;
+      
+      var typemap = (kind=="ctxt"? ctxtValType: traceValType);
+      if(!(key in typemap)) typemap[key]="number";
+      
+      var key2ID = (kind=="ctxt"? ctxtKey2ID[traceLabel]: traceKey2ID[traceLabel]);
+      var keys   = (kind=="ctxt"? ctxtKeys[traceLabel]:   traceKeys[traceLabel]);
+      if(key2ID[key] == undefined) {
+        key2ID[key] = keys.length;
+        keys.push(key);
+      }
+    }
+    traceColumnData[traceLabel] = data;
+    
+    // Show the trace in all the places where it was requested while it was loading
+    var waiting = traceColumnWaiting[traceLabel];
+    delete traceColumnWaiting[traceLabel];
+    for(var w=0; w<waiting.length; w++) displayTrace.apply(null, waiting[w]);
+  });
+}
+
+// Returns the column of the given key in the given trace's binary columns, or undefined if there is none
+function getTraceColumn(traceLabel, key) {
+  var data = traceColumnData[traceLabel];
+  if(data.ctxt.hasOwnProperty(key))  return data.ctxt[key];
+  if(data.trace.hasOwnProperty(key)) return data.trace[key];
+  return undefined;
+}
+
+// Returns the list of the given trace's observations, creating it from the trace's binary columns if needed
+function getTraceDataList(traceLabel) {
+  if(traceColumnData.hasOwnProperty(traceLabel) && !traceDataList.hasOwnProperty(traceLabel)) {
+    var data = traceColumnData[traceLabel];
+    var list = [];
+    for(var i=0; i<data.n; i++) {
+      var allVals = {};
+      for(var key in data.ctxt)  { if(data.ctxt.hasOwnProperty(key)  && !isNaN(data.ctxt[key][i]))  allVals[key] = data.ctxt[key][i]; }
+      for(var key in data.trace) { if(data.trace.hasOwnProperty(key) && !isNaN(data.trace[key][i])) allVals[key] = data.trace[key][i]; }
+      list.push(allVals);
+    }
+    traceDataList[traceLabel] = list;
+  }
+  return traceDataList[traceLabel];
+}
+
 // Given a mapping of trace/context keys to the types of their values,
 // updates the mapping that, taking the next observation of the value into account 
 function updateKeyValType(typemap, key, val) {
@@ -236,6 +354,9 @@ var displayTraceCalled = {};
 }*/
 
 function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFresh, showLabels) {
+  // If the trace's binary columns are still loading, show it once they arrive
+  if(traceColumnWaiting.hasOwnProperty(traceLabel)) { traceColumnWaiting[traceLabel].push(arguments); return; }
+  
   var numContextAttrs=0;
   for(i in ctxtAttrs) { if(ctxtAttrs.hasOwnProperty(i)) { numContextAttrs++; } }
   
@@ -247,7 +368,7 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
   if(viz == 'table') {
     // NOTE: we always overwrite prior contents regardless of the value of showFresh, although this can be fixed in the future
     
-    showTable(traceDataList[traceLabel], hostDivID, ctxtAttrs[0]);
+    showTable(getTraceDataList(traceLabel), hostDivID, ctxtAttrs[0]);
     
     /*var ctxtCols = [];
     for(i in ctxtAttrs) { if(ctxtAttrs.hasOwnProperty(i)) {
@@ -290,12 +411,34 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
     if(showFresh) hostDiv.innerHTML =  newDiv;
     else          hostDiv.innerHTML += newDiv;
     
+    // If the trace has too many observations to show them individually, show its level-of-detail pyramid
+    if(hasTraceLOD(traceLabel)) {
+      showLinesLOD(traceLabel, ctxtAttrs[0], traceAttrs, hostDivID+"_"+cStr);
+      return;
+    }
+    
     var data = [];
-    for(i in traceDataList[traceLabel]) { if(traceDataList[traceLabel].hasOwnProperty(i)) {
-    for(t in traceAttrs) { if(traceAttrs.hasOwnProperty(t)) {
-      data.push([traceDataList[traceLabel][i][ctxtAttrs[0]], 
-                 traceDataList[traceLabel][i][traceAttrs[t]]]);
-    } } } }
+    // If the trace was emitted as binary columns, read the points directly from them
+    if(traceColumnData.hasOwnProperty(traceLabel)) {
+      var xCol = getTraceColumn(traceLabel, ctxtAttrs[0]);
+      var yCols = [];
+      for(t in traceAttrs) { if(traceAttrs.hasOwnProperty(t)) {
+        var yCol = getTraceColumn(traceLabel, traceAttrs[t]);
+        if(yCol) yCols.push(yCol);
+      } }
+      if(xCol) {
+        for(var i=0; i<traceColumnData[traceLabel].n; i++) {
+        for(var t=0; t<yCols.length; t++) {
+          if(!isNaN(xCol[i]) && !isNaN(yCols[t][i])) data.push([xCol[i], yCols[t][i]]);
+        } }
+      }
+    } else {
+      for(i in traceDataList[traceLabel]) { if(traceDataList[traceLabel].hasOwnProperty(i)) {
+      for(t in traceAttrs) { if(traceAttrs.hasOwnProperty(t)) {
+        data.push([traceDataList[traceLabel][i][ctxtAttrs[0]], 
+                   traceDataList[traceLabel][i][traceAttrs[t]]]);
+      } } } }
+    }
     showScatterplot(data, hostDivID+"_"+cStr);
     
     /*
@@ -351,7 +494,24 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
       if(showFresh) hostDiv.innerHTML =  newDiv;
       else          hostDiv.innerHTML += newDiv;
     
+      // If the trace has too many observations to show them individually, show its level-of-detail octree
+      if(hasTraceLOD(traceLabel)) {
+        showScatter3DLOD(traceLabel, [ctxtAttrs[0], ctxtAttrs[1], ctxtAttrs[2]], plotDivID);
+        return;
+      }
+    
       var data = [];
+      // If the trace was emitted as binary columns, read the points directly from them
+      if(traceColumnData.hasOwnProperty(traceLabel)) {
+        var cols = [];
+        for(var c=0; c<3; c++) cols.push(getTraceColumn(traceLabel, ctxtAttrs[c]));
+        for(var t=0; t<4; t++) cols.push(t<traceAttrs.length? getTraceColumn(traceLabel, traceAttrs[t]): undefined);
+        for(var i=0; i<traceColumnData[traceLabel].n; i++) {
+          var point = [];
+          for(var c=0; c<cols.length; c++) point.push(cols[c] && !isNaN(cols[c][i])? cols[c][i]: undefined);
+          data.push(point);
+        }
+      } else
       for(var i in traceDataList[traceLabel]) { if(traceDataList[traceLabel].hasOwnProperty(i)) {
 //      for(var t in traceAttrs) { if(traceAttrs.hasOwnProperty(t)) {
         data.push([traceDataList[traceLabel][i][ctxtAttrs[0]], 
@@ -383,7 +543,7 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
     else          hostDiv.innerHTML += newDiv;
     
     //if(!displayTraceCalled.hasOwnProperty(traceLabel)) {
-    traceDataList[traceLabel] = _(traceDataList[traceLabel]);
+    traceDataList[traceLabel] = _(getTraceDataList(traceLabel));
     var model = id3(traceDataList[traceLabel], traceAttrs[0], ctxtAttrs);
     //alert(document.getElementById(hostDivID).innerHTML)
     // Create a div in which to place this attribute's decision tree
@@ -428,13 +588,18 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
           // Escape problematic characters
           var cStr=ctxtAttrs[c].replace(/:/g, "-");
           var tStr=traceAttrs[t].replace(/:/g, "-");
-          showBoxPlot(traceDataList[traceLabel], hostDivID + "_" + cStr + "_" + tStr, ctxtAttrs[c], traceAttrs[t], width, height, margin);
+          // If slayout summarized the observations, show the summaries. Otherwise, compute the boxplot from the raw observations.
+          var summaries = getBoxplotSummaries(traceLabel, ctxtAttrs[c], traceAttrs[t]);
+          if(summaries) showBoxPlotSummaries(summaries, hostDivID + "_" + cStr + "_" + tStr, width, height, margin);
+          else          showBoxPlot(getTraceDataList(traceLabel), hostDivID + "_" + cStr + "_" + tStr, ctxtAttrs[c], traceAttrs[t], width, height, margin);
         } } } }
       } else {
         for(t in traceAttrs) {   if(traceAttrs.hasOwnProperty(t)) {
           // Escape problematic characters
           var tStr=traceAttrs[t].replace(/:/g, "-");
-          showBoxPlot(traceDataList[traceLabel], hostDivID+"_"+tStr, "", traceAttrs[t], width, height, margin);
+          var summaries = getBoxplotSummaries(traceLabel, "", traceAttrs[t]);
+          if(summaries) showBoxPlotSummaries(summaries, hostDivID+"_"+tStr, width, height, margin);
+          else          showBoxPlot(getTraceDataList(traceLabel), hostDivID+"_"+tStr, "", traceAttrs[t], width, height, margin);
         } }
       }
     }
@@ -490,13 +655,16 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
         
         var traceVals = getDataHash(traceDataHash[traceLabel], contextVals);
         var traceLinks = getDataHash(traceLinkHash[traceLabel], contextVals);
+        // The sketches of the tile's observations, if slayout summarized them
+        var traceSketches = (traceSketchHash.hasOwnProperty(traceLabel)? getDataHash(traceSketchHash[traceLabel], contextVals): undefined);
         // If there is a record for this combination of context key values, add it to the dataset
         if(traceVals && traceLinks)
           attrData.push({row: k1, 
                          col:k0, 
                          traceAttrIdx:traceAttrIdx,
                          traceVals:traceVals, 
-                         traceLinks:traceLinks});
+                         traceLinks:traceLinks,
+                         traceSketches:traceSketches});
       } } } }
       
       // Add the data for the current trace attribute to the dataset
@@ -511,8 +679,8 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
                       //.attr("class", "tooltip")    
                       .style("position",       "absolute")
                       .style("text-align",     "center")
-                      .style("width",          "60px")
-                      .style("height",         "14px")
+                      .style("min-width",      "60px")
+                      .style("min-height",     "14px")
                       .style("padding",        "2px")
                       .style("font",           "12px sans-serif")
                       .style("background",     "lightsteelblue")
@@ -568,6 +736,9 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
             tooltip.html(d["traceVals"][traceAttrs[d["traceAttrIdx"]]])  
                 .style("left", (d3.event.pageX) + "px")     
                 .style("top", (d3.event.pageY - 28) + "px");    
+            // If the tile summarizes multiple observations, show their histogram
+            if(d["traceSketches"] && d["traceSketches"][traceAttrs[d["traceAttrIdx"]]])
+              showTileHistogram(tooltip, d["traceSketches"][traceAttrs[d["traceAttrIdx"]]]);
             })                  
         .on("mouseout", function(d) {       
             tooltip.transition()        
@@ -579,3 +750,23 @@ function displayTrace(traceLabel, hostDivID, ctxtAttrs, traceAttrs, viz, showFre
   displayTraceCalled = true;
 }
 
+// Appends to the given tooltip a small bar chart of the given histogram sketch: {n:, bins:[[lo, hi, count], ...]}
+function showTileHistogram(tooltip, sketch) {
+  var barWidth=4, chartHeight=40;
+  var maxCount=0;
+  for(var b=0; b<sketch.bins.length; b++) maxCount = Math.max(maxCount, sketch.bins[b][2]);
+  
+  tooltip.append("div").text("n="+sketch.n);
+  var svg = tooltip.append("svg")
+                     .attr("width",  Math.max(barWidth*sketch.bins.length, 60))
+                     .attr("height", chartHeight);
+  svg.selectAll("rect")
+       .data(sketch.bins)
+     .enter()
+       .append("rect")
+         .attr("x",      function(d, i) { return i*barWidth; })
+         .attr("y",      function(d) { return chartHeight - chartHeight*d[2]/maxCount; })
+         .attr("width",  barWidth-1)
+         .attr("height", function(d) { return chartHeight*d[2]/maxCount; })
+         .attr("fill", "#000000");
+}
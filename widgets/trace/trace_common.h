@@ -1,6 +1,9 @@
 #pragma once
 
 #include <map>
+#include <set>
+#include <vector>
+#include <string>
 
 namespace sight {
 
@@ -31,6 +34,136 @@ class trace {
   static std::string viz2Str(vizT viz);
 };
 
+/**************************
+ ***** Trace sketches *****
+ **************************/
+
+// Mergeable summaries of the values of a single trace attribute observed within a single context. They make
+// it possible to visualize distributions of very large numbers of observations (boxplots, heatmaps) without
+// keeping or shipping each individual observation, and summaries of disjoint sets of observations (e.g. the
+// same trace from different streams) can be combined into a summary of their union.
+
+// Quantile sketch in the style of KLL: a hierarchy of compactors where level i holds retained items that each 
+// stand for 2^i observations. When a level fills up it is sorted and every other item (alternating between 
+// the odd and even ones to keep the rank error unbiased) is promoted to the next level. The total space used
+// is O(k log(n/k)) and the rank error is O(1/k). The exact count, sum, minimum and maximum are also kept.
+class quantileSketch {
+  // The capacity of each compactor level
+  int k;
+  
+  // levels[i] contains the items retained at level i, each of which has weight 2^i
+  std::vector<std::vector<double> > levels;
+  
+  // Alternates between true and false on each compaction to choose which half of a level is promoted
+  bool oddCompaction;
+  
+  // Exact statistics of all the observations summarized by this sketch
+  long n;
+  double sum;
+  double minV;
+  double maxV;
+  
+  public:
+  quantileSketch(int k=200);
+  
+  // Reconstructs a sketch from the encoding returned by serialize()
+  quantileSketch(const std::string& serialized);
+  
+  // Adds a single observation to the sketch
+  void add(double v);
+  
+  // Updates this sketch to summarize the union of its observations and those of that
+  void merge(const quantileSketch& that);
+  
+  long   count()   const { return n; }
+  double getSum()  const { return sum; }
+  double getMin()  const { return minV; }
+  double getMax()  const { return maxV; }
+  double getMean() const { return (n>0? sum/n: 0); }
+  
+  // Returns the approximate value at quantile q (0<=q<=1)
+  double quantile(double q) const;
+  
+  // Returns the items retained by the sketch, sorted by value and paired with their weights
+  std::vector<std::pair<double, long> > getWeightedItems() const;
+  
+  // Returns the number of items currently retained by the sketch
+  int numRetained() const;
+  
+  // Returns a JavaScript object that describes the boxplot of the observations summarized by this sketch:
+  // {n:, min:, max:, mean:, quartiles:[q1, q2, q3], whiskers:[lo, hi], outliers:[...]}. 
+  // Whiskers are placed at the most extreme retained values within 1.5 IQRs of the quartiles and at most 
+  // maxOutliers retained values beyond the whiskers are listed as outliers.
+  std::string boxplotJS(int maxOutliers=100) const;
+  
+  // Returns a string encoding of this sketch, which hier_merge uses to carry the sketches of merged
+  // streams to the layout
+  std::string serialize() const;
+  
+  std::string str() const;
+  
+  private:
+  // Compacts any levels that have reached capacity
+  void compress();
+}; // class quantileSketch
+
+// Histogram with fixed, logarithmically-spaced bins: each power of 2 is divided into binsPerOctave bins 
+// and negative values are placed into the mirror images of the positive bins. Since the bin boundaries 
+// do not depend on the observed data, histograms of different sets of observations are merged by adding 
+// their bin counts. The exact count, sum, minimum and maximum are also kept.
+class histogramSketch {
+  // The number of bins into which each power of 2 is divided
+  int binsPerOctave;
+  
+  // Maps each non-empty bin to its count. A bin is identified by the sign of its values (-1, 0 or 1) and 
+  // the index of its logarithmic bin among the bins of the same sign. All 0 observations go to the bin (0, 0).
+  std::map<std::pair<int, int>, long> bins;
+  
+  long n;
+  double sum;
+  double minV;
+  double maxV;
+  
+  public:
+  histogramSketch(int binsPerOctave=4);
+  
+  // Reconstructs a histogram from the encoding returned by serialize()
+  histogramSketch(const std::string& serialized);
+  
+  // Adds a single observation to the histogram
+  void add(double v);
+  
+  // Updates this histogram to summarize the union of its observations and those of that
+  void merge(const histogramSketch& that);
+  
+  long   count()   const { return n; }
+  double getSum()  const { return sum; }
+  double getMin()  const { return minV; }
+  double getMax()  const { return maxV; }
+  double getMean() const { return (n>0? sum/n: 0); }
+  
+  // Returns the value that corresponds to the given merge policy: the mean for avgMerge and disjMerge,
+  // the maximum for maxMerge and the minimum for minMerge
+  double getAggregate(trace::mergeT merge) const;
+  
+  // Returns a JavaScript array that lists the non-empty bins of this histogram in increasing order:
+  // [[lo, hi, count], ...]. The lowest and highest bins are clipped to the observed minimum and maximum.
+  std::string binsJS() const;
+  
+  // Returns a string encoding of this histogram, which hier_merge uses to carry the histograms of merged
+  // streams to the layout
+  std::string serialize() const;
+  
+  std::string str() const;
+  
+  private:
+  // Returns the bin that contains v
+  std::pair<int, int> bin(double v) const;
+  
+  // Returns the lower and upper boundaries of the given bin
+  std::pair<double, double> binRange(const std::pair<int, int>& b) const;
+}; // class histogramSketch
+
 /*******************************************
  ***** Support for parsing trace files *****
  *******************************************/
@@ -58,5 +191,156 @@ std::string serializeTraceObservation(const std::map<std::string, attrValue>& ct
                                       const std::map<std::string, attrValue>& obs,
                                       const std::map<std::string, int>& anchor);
 
+/***********************
+ ***** Trace store *****
+ ***********************/
+
+// Append-only columnar store of trace observations that persists across runs. slayout and hier_merge 
+// write the observations of every traceStream into it (when SIGHT_TRACE_STORE names its root directory),
+// making it possible to analyze metrics across many runs with queries rather than by browsing each 
+// run's visualization.
+//
+// The store is organized into segments, each of which holds the observations of a single trace recorded
+// by a single process within a single run and is keyed by (run, group, traceID). The group is the label of 
+// the trace or the name of the module group whose observations it records. The processes of a run that record 
+// the same trace (e.g. the ranks of an MPI job) write separate segments with the same key, which queries combine.
+// Each segment is a directory that contains:
+//   - schema: one line "ctxt|obs <name> num|str <firstRow>" for each column, in order of creation, where 
+//             firstRow is the number of rows the segment had when the column was first observed
+//   - c<i>: the values of column i, as doubles (num) or as 32-bit indexes into dictionary c<i>.dict (str)
+//   - c<i>.dict: the distinct strings of str column i, one per line
+//   - zones: index that records the minimum and maximum value of each num column within each block of 
+//            traceStore::blockRows rows, used to skip blocks during queries
+//   - rows: the number of complete rows in the segment
+// The catalog file at the root lists all the segments, one per line: "<run>\t<group>\t<traceID>\t<dir>".
+class traceStore {
+  public:
+  // The number of rows in each block of the zone index
+  static const int blockRows = 4096;
+  
+  // Returns the root directory of the store, as set via SIGHT_TRACE_STORE, or "" if the store is disabled
+  static std::string getRoot();
+  
+  // Returns the ID of the current run. Defaults to <hostname>.<time>.<pid> and can be set via SIGHT_RUN_ID.
+  static std::string getRunID();
+  
+  // Returns a version of the given string that can be used as a file name
+  static std::string fileNameSafe(const std::string& s);
+  
+  // Describes a single segment of the store
+  class segment {
+    public:
+    std::string run;
+    std::string group;
+    std::string traceID;
+    std::string dir;
+  };
+  
+  // Describes a single column of a segment
+  class column {
+    public:
+    bool        isCtxt;
+    std::string name;
+    bool        isNum;
+    long        firstRow;
+  };
+  
+  // Reads the catalog of the store at the given root
+  static std::vector<segment> readCatalog(const std::string& root);
+  
+  // Reads the schema and number of rows of the given segment
+  static std::vector<column> readSchema(const std::string& segDir, long& numRows);
+}; // class traceStore
+
+// Writes the observations of a single trace into a segment of the trace store
+class traceStoreWriter {
+  // The directory of the segment
+  std::string dir;
+  
+  // The columns of the segment and the mapping from the names of context and trace attributes to their indexes
+  std::vector<traceStore::column> columns;
+  std::map<std::string, int> ctxtIdx, obsIdx;
+  
+  // Values of the num and str columns of the current block, indexed by column
+  std::vector<std::vector<double> > numVals;
+  std::vector<std::vector<int> >    strVals;
+  
+  // Maps the strings of each str column to their indexes in its dictionary
+  std::vector<std::map<std::string, int> > dicts;
+  // The entries of each column's dictionary that have not yet been written out
+  std::vector<std::vector<std::string> > newDictEntries;
+  
+  // The number of rows in the segment and the index of the first row of the current block
+  long numRows;
+  long blockStart;
+  
+  public:
+  traceStoreWriter(const std::string& root, const std::string& run, const std::string& group, const std::string& traceID);
+  ~traceStoreWriter();
+  
+  // Appends a single observation to the segment
+  void append(const std::map<std::string, std::string>& ctxt, const std::map<std::string, std::string>& obs);
+  
+  // Writes the current block to the segment's files
+  void flush();
+  
+  // Returns the writer for the segment of the trace with the given group and ID within the current run,
+  // creating it if needed, or NULL if the store is disabled. All such writers are flushed and closed when
+  // the process exits.
+  static traceStoreWriter* get(const std::string& group, const std::string& traceID);
+  
+  // Flushes and closes the writer of the trace with the given group and ID, if it exists
+  static void close(const std::string& group, const std::string& traceID);
+  
+  private:
+  // Returns the index of the given column, adding it to the segment if it is new. valStr is the first 
+  // value observed for it, which determines its type.
+  int getColumn(bool isCtxt, const std::string& name, const std::string& valStr);
+  
+  // Stores the given value into the current row of the given column
+  void setValue(int col, const std::string& valStr);
+}; // class traceStoreWriter
+
+// A query on the trace store that selects observations by segment and by ranges of column values, groups
+// them by the values of some columns and computes aggregates of other columns within each group
+class traceStoreQuery {
+  public:
+  // If non-empty, only segments with these runs, groups and traceIDs are considered
+  std::set<std::string> runs, groups, traceIDs;
+  
+  // Only rows where the value of each column falls within its range [lo, hi] are selected.
+  // Rows where the column is not numeric or has no value are not selected.
+  std::map<std::string, std::pair<double, double> > ranges;
+  
+  // The columns by which selected rows are grouped. The pseudo-columns run, group and traceID refer to 
+  // the key of each row's segment.
+  std::vector<std::string> groupBy;
+  
+  // The aggregates to compute for each group
+  typedef enum {count, sum, min, max, avg} aggT;
+  std::vector<std::pair<aggT, std::string> > aggregates;
+  
+  // Returns the aggT that corresponds to the given name, or -1 if there is none
+  static int str2agg(const std::string& name);
+  static std::string agg2str(aggT agg);
+  
+  // Maps the values of the groupBy columns of each group to the values of its aggregates
+  typedef std::map<std::vector<std::string>, std::vector<double> > result;
+  
+  // Runs the query on the store at the given root
+  result run(const std::string& root) const;
+  
+  private:
+  // The running state of all of a group's aggregates
+  class aggState {
+    public:
+    std::vector<long>   n;
+    std::vector<double> sum, min, max;
+  };
+  
+  // Runs the query on a single segment, updating the states of the groups it contributes to
+  void runSegment(const traceStore::segment& seg, std::map<std::vector<std::string>, aggState>& states) const;
+}; // class traceStoreQuery
+
 }; // namespace common
 }; // namespace sight
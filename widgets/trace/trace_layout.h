@@ -222,6 +222,9 @@ class traceStream: public attrObserver, public common::trace, public traceObserv
   public:
   vizT viz;
   
+  // The way observations of this trace from different streams were combined
+  mergeT merge;
+  
   // Maps the traceIDs of all the currently active traces to their trace objects
   static std::map<int, traceStream*> active;
 
@@ -256,6 +259,10 @@ class traceStream: public attrObserver, public common::trace, public traceObserv
   // when it is shown.
   bool showTrace;
   
+  // The group under which this stream's observations are recorded in the trace store: the label of 
+  // its trace or the name of its module group
+  std::string storeGroup;
+  
   public:
   // hostDiv - the div where the trace data should be displayed
   // showTrace - indicates whether the trace should be shown by default (true) or whether the host will control
@@ -278,6 +285,10 @@ class traceStream: public attrObserver, public common::trace, public traceObserv
                               std::string hostDiv="", vizT viz=unknown, bool showFresh=true, bool showLabels=false);
   
   int getID() const { return traceID; }
+  
+  // Sets the group under which this stream's observations are recorded in the trace store. Must be
+  // called before the first observation.
+  void setStoreGroup(const std::string& group) { storeGroup = group; }
   private:
   // Place the code to show the visualization
   void showViz();
@@ -290,10 +301,166 @@ class traceStream: public attrObserver, public common::trace, public traceObserv
   // Records all the observations of trace variables since the last time variables in contextAttrs changed values
   std::map<std::string, std::pair<attrValue, anchor> > obs;
   
+  private:
+  // For visualizations that show the distribution of observations (boxplot, heatmap) we don't emit each
+  // observation to the browser. Instead, we summarize the observations within each context (the values of 
+  // all the context attributes) in mergeable sketches and emit only the sketches when the stream finishes.
+  
+  // Returns whether this stream summarizes its observations with sketches
+  bool useSketches() const { return viz==boxplot || viz==heatmap; }
+  
+  // Maps each context to the quantile sketches of each trace attribute's values (boxplot)
+  std::map<std::map<std::string, std::string>, std::map<std::string, common::quantileSketch> > ctxtQuantiles;
+  
+  // Maps each context to the histograms of each trace attribute's values (heatmap)
+  std::map<std::map<std::string, std::string>, std::map<std::string, common::histogramSketch> > ctxtHistograms;
+  
+  // Maps each context to the most recent anchor of each trace attribute
+  std::map<std::map<std::string, std::string>, std::map<std::string, anchor> > ctxtAnchors;
+  
+  // Adds the given observation to the sketches of its context
+  void addToSketches(const std::map<std::string, std::string>& ctxt, 
+                     const std::map<std::string, std::string>& obs,
+                     const std::map<std::string, anchor>&      obsAnchor);
+  
+  // Emits the summaries of all the sketches to the browser
+  void emitSketches();
+  
+  // Visualizations that show individual points (lines, scatter3d) become unusable when the browser needs
+  // to load and draw very many points. If a stream has more than lodThreshold observations we do not 
+  // emit them individually but instead emit a multi-resolution pyramid of the points: the browser 
+  // first shows the coarsest level and loads finer tiles from separate files as the user zooms in.
+  // For lines each tile holds the M4 decimation (first, last, min and max point of each bucket) of its 
+  // x-range and for scatter3d each node of an octree holds a stratified sample of its points.
+  // Since the number of observations is only known when the stream finishes, its observations are 
+  // buffered until then, so that each stream is emitted either as a pyramid or as individual observations.
+  // If a non-numeric observation arrives, the buffered observations are emitted individually and so
+  // are all the stream's later observations.
+  
+  // The number of observations beyond which streams switch to level-of-detail pyramids.
+  // Set via the SIGHT_TRACE_LOD_THRESHOLD environment variable.
+  static long lodThreshold;
+  
+  // Returns whether this stream's visualization can use level-of-detail pyramids
+  bool useLOD() const { return viz==lines || viz==scatter3d; }
+  
+  // The number of observations in the level-of-detail buffer
+  long numObs;
+  
+  // Records whether all the observations so far were numeric and thus can be placed in a pyramid
+  bool lodPossible;
+  
+  // The values of each context and trace attribute across the buffered observations, with NaN for the 
+  // observations that do not include the attribute
+  std::map<std::string, std::vector<double> > lodCtxtCols;
+  std::map<std::string, std::vector<double> > lodTraceCols;
+  
+  // Maps the indexes of the buffered observations that have anchors to those anchors
+  std::map<long, std::map<std::string, anchor> > lodAnchors;
+  
+  // lines: maps each pair of context and trace attribute to the (x, y) points observed for it
+  std::map<std::pair<std::string, std::string>, std::vector<std::pair<double, double> > > linePoints;
+  
+  // scatter3d: the observed points, stored as lodScatterNumCols columns: the values of the 3 context
+  // attributes followed by the values of the first 4 trace attributes
+  static const int lodScatterNumCols = 7;
+  std::vector<double> scatterCols[lodScatterNumCols];
+  
+  // Adds the given observation to this stream's level-of-detail buffer. Returns true if the observation
+  // should instead be emitted individually and false otherwise.
+  bool addToLOD(const std::map<std::string, std::string>& ctxt, 
+                const std::map<std::string, std::string>& obs,
+                const std::map<std::string, anchor>&      obsAnchor);
+  
+  // Emits the observations in the level-of-detail buffer individually and clears it
+  void flushLOD();
+  
+  // Computes linePoints or scatterCols from the level-of-detail buffer, releasing each of its columns as 
+  // soon as it has been converted
+  void lodBufferToPoints();
+  
+  // Emits the level-of-detail pyramids of this stream, if it needs them
+  void emitLOD();
+  
+  // Emits the tile of the given lines series at the given level that contains points [begin, end), 
+  // which are sorted by x and span x-range [lo, hi), as well as all of its sub-tiles
+  void emitLinesLODTile(int seriesIdx, int level, long tile, double lo, double hi,
+                        std::vector<std::pair<double, double> >::iterator begin,
+                        std::vector<std::pair<double, double> >::iterator end,
+                        const std::pair<std::string, std::string>& dirs);
+  
+  // Emits the given scatter3d octree node, which holds points idx[begin, end) and spans the given 
+  // bounding box, as well as all of its descendants
+  void emitScatterLODNode(std::string nodeID, std::vector<long>& idx, long begin, long end,
+                          const double* bbMin, const double* bbMax, int numCols, 
+                          const std::pair<std::string, std::string>& dirs);
+  
+  // Emits the given JavaScript command into the page's scripts if fName is empty and otherwise into
+  // file fName in the level-of-detail directory dirs (absolute path, path relative to the html directory)
+  void emitLODCommand(std::string command, std::string fName, const std::pair<std::string, std::string>& dirs);
+
+  // Visualizations that show individual observations (table, lines, scatter3d, decTree) are slow to load
+  // when each observation is a separate traceRecord() statement that the browser must parse and evaluate.
+  // Numeric observations are therefore buffered as columns, one per context and trace attribute. If the
+  // stream has more than binaryThreshold observations, all numeric and without anchors, each column is
+  // written as a packed Int32 (if all of its values fit) or Float64 array into a single binary file and
+  // only a small manifest of the columns is emitted into the page. trace.js loads the file in a single
+  // request and renders directly from typed array views of it. Smaller streams and streams with
+  // non-numeric values are emitted as traceRecord() statements.
+
+  // The number of observations beyond which streams are emitted as binary columns. Set via the
+  // SIGHT_TRACE_BINARY_THRESHOLD environment variable. Binary columns are disabled if it is negative.
+  static long binaryThreshold;
+
+  // The values of a single attribute across all the buffered observations. Observations that do not
+  // include the attribute have value NaN.
+  class traceColumn {
+    public:
+    std::vector<double> vals;
+    // Records whether all of the values are integers that fit in 32 bits
+    bool isInt;
+    traceColumn() : isInt(true) {}
+  };
+
+  // The columns of the context and trace attributes
+  std::map<std::string, traceColumn> ctxtCols;
+  std::map<std::string, traceColumn> traceCols;
+
+  // The number of observations buffered in the columns
+  long numColObs;
+
+  // Records whether all the observations so far can be buffered in columns
+  bool colsPossible;
+
+  // Adds the given observation to this stream's columns. Returns true if the observation should be
+  // emitted individually and false otherwise.
+  bool addToColumns(const std::map<std::string, std::string>& ctxt,
+                    const std::map<std::string, std::string>& obs,
+                    const std::map<std::string, anchor>&      obsAnchor);
+
+  // Emits the observations buffered in the columns, either as binary columns or as individual records
+  void emitColumns();
+
+  // Emits the observations buffered in the columns as individual records and clears the columns
+  void emitColumnsAsRecords();
+
+  // Emits a single observation as a traceRecord() statement
+  void emitRecord(const std::map<std::string, std::string>& ctxt,
+                  const std::map<std::string, std::string>& obs,
+                  const std::map<std::string, anchor>&      obsAnchor);
+
+  // Records the names of the given context attributes and of the trace attributes in the given observation
+  void recordAttrNames(const std::map<std::string, std::string>& ctxt, 
+                       const std::map<std::string, std::string>& obs);
+
   public:
   // Record an observation
   static void* observe(properties::iterator props);
   
+  // Record the sketches of the observations of a single context, which hier_merge emits in place of the
+  // observations of boxplot and heatmap traces
+  static void* observeSketch(properties::iterator props);
+  
   // Called on each observation from the traceObserver this object is observing
   // traceID - unique ID of the trace from which the observation came
   // ctxt - maps the names of the observation's context attributes to string representations of their values
@@ -12,6 +12,7 @@
 #include "../../sight_common.h"
 #include "../../sight_structure_internal.h"
 #include <sys/time.h>
+#include <time.h>
 #include <papi.h>
 
 namespace sight {
@@ -333,15 +334,30 @@ class measure {
 typedef common::easylist<measure*> measures;
 typedef common::easymap<std::string, measure*> namedMeasures;
 
+// Measures elapsed time using tickClock. Time is accumulated as integral clock ticks and converted to seconds 
+// only when the measurement is emitted. The clock is calibrated once, when Sight is initialized, which includes 
+// measuring the overhead of an empty measurement. This overhead is subtracted from each interval the measure 
+// times to keep fine-grained measurements from being dominated by the cost of measuring them.
 class timeMeasure : public measure {
-  // Counts the total time elapsed so far, accounting for any pauses and resumes
-  double elapsed;
-  // The time when we started or resumed this measure, whichever is most recent
-  struct timeval lastStart;
+  // Counts the total number of clock ticks elapsed so far, accounting for any pauses and resumes
+  long long elapsed;
+  // The tick count when we started or resumed this measure, whichever is most recent
+  unsigned long long lastStart;
   
   // The label associated with this measurement
   std::string valLabel;
   
+  // Records whether the overhead of an empty measurement has been measured
+  static bool calibrated;
+  
+  // The number of ticks that an empty measurement interval reports, which is subtracted from every interval
+  static long long overheadTicks;
+  
+  public:
+  // Calibrates tickClock, unless it has already been calibrated, and measures the overhead of an empty 
+  // measurement. Called once when Sight is initialized and may be called again to re-measure the overhead.
+  static void calibrate();
+  
   public:
   // Non-full measure
   timeMeasure(                        std::string valLabel="time");
@@ -465,6 +481,88 @@ class PAPIMeasure : public measure {
   std::string str() const;
 }; // class PAPIMeasure
 
+// Syntactic sugar for specifying the events measured by perfMeasure, using the names reported by perf list
+// (e.g. "instructions", "cycles", "cache-misses", "task-clock", "page-faults", "context-switches") or 
+// raw event codes of the form "r<hex code>".
+typedef common::easyvector<std::string> perfEvents;
+
+// A group of perf_event counters that measures a given set of events. Defined in trace_structure.C.
+class perfEventGroup;
+
+// Measures the counts of hardware and software events using the Linux perf_event_open() interface directly,
+// rather than through PAPI. All the events of a measure are opened as a single group that is shared by all 
+// perfMeasures with the same events, counts continuously and is read in a single system call or, where the kernel
+// permits it, via the rdpmc instruction without entering the kernel. On machines where the hardware events cannot
+// be opened (e.g. virtual machines without PMU access), the measure falls back to the software events task-clock, 
+// page-faults and context-switches and labels its observations accordingly.
+class perfMeasure : public measure {
+  // Counts the total number of counter events observed so far, accounting for any pauses and resumes
+  std::vector<long long> accumValues;
+  
+  // The values of the counters recorded when measurement last started or restarted, followed by the
+  // times the group had been enabled and running
+  std::vector<long long> lastValues;
+  
+  // Buffer into which we'll read counters
+  std::vector<long long> readValues;
+  
+  // The events that will be measured
+  perfEvents events;
+
+  // The label associated with this measurement
+  std::string valLabel;
+  
+  // The group of counters that measures this measure's events on the thread that created this measure, 
+  // or NULL if they could not be opened. The measure counts only the events of that thread.
+  perfEventGroup* group;
+  
+  public:
+  perfMeasure(const perfEvents& events);
+  
+  // Non-full measure
+  perfMeasure(                        std::string valLabel, const perfEvents& events);
+  perfMeasure(std::string traceLabel, std::string valLabel, const perfEvents& events);
+  perfMeasure(trace* t,               std::string valLabel, const perfEvents& events);
+  perfMeasure(traceStream* ts,        std::string valLabel, const perfEvents& events);
+  // Full measure
+  perfMeasure(                        std::string valLabel, const std::map<std::string, attrValue>& fullMeasureCtxt, const perfEvents& events);
+  perfMeasure(std::string traceLabel, std::string valLabel, const std::map<std::string, attrValue>& fullMeasureCtxt, const perfEvents& events);
+  perfMeasure(trace* t,               std::string valLabel, const std::map<std::string, attrValue>& fullMeasureCtxt, const perfEvents& events);
+  perfMeasure(traceStream* ts,        std::string valLabel, const std::map<std::string, attrValue>& fullMeasureCtxt, const perfEvents& events);
+  
+  perfMeasure(const perfMeasure& that);
+  
+  ~perfMeasure();
+ 
+  private:
+  // Common initialization code
+  void init();   
+          
+  public:
+  // Returns a copy of this measure object, including its current measurement state, if any
+  measure* copy() const;
+    
+  // Start the measurement
+  void start();
+   
+  // Pauses the measurement so that time elapsed between this call and resume() is not counted.
+  // Returns true if the measure is not currently paused and false if it is (i.e. the pause command has no effect)
+  bool pause();
+
+  // Restarts counting time. Time collection is restarted regardless of how many times pause() was called
+  // before the call to resume().
+  void resume();
+ 
+  // Complete the measurement and add the observation to the trace associated with this measurement
+  void end();
+  
+  // Complete the measurement and return the observation.
+  // If addToTrace is true, the observation is addes to this measurement's trace and not, otherwise
+  std::list<std::pair<std::string, attrValue> > endGet(bool addToTrace=false);
+  
+  std::string str() const;
+}; // class perfMeasure
+
 // Non-full measure
 template<class MT>
 MT* startMeasure(std::string traceLabel, std::string valLabel) {
@@ -529,6 +627,15 @@ RET endGetMeasure(MT* m) {
 }*/
 
 
+// Emits the summary of the time spent inside Sight, as measured by sightOverhead, as a trace
+void emitOverheadTrace();
+
+class TraceSightInitHandlerInstantiator: public SightInitHandlerInstantiator {
+  public:
+  TraceSightInitHandlerInstantiator();
+};
+extern TraceSightInitHandlerInstantiator TraceSightInitHandlerInstance;
+
 class TraceMergeHandlerInstantiator: public MergeHandlerInstantiator {
   public:
   TraceMergeHandlerInstantiator();
@@ -650,6 +757,29 @@ class TraceStreamRecord: public streamRecord {
   // Maps traceIDs to their merge types
   std::map<int, trace::mergeT> merge;
   
+  // Maps traceIDs to their visualization types
+  std::map<int, trace::vizT> viz;
+  
+  // Maps traceIDs to the groups under which their observations are recorded in the trace store
+  std::map<int, std::string> group;
+  
+  // The group of the next traceStream to be entered: the label of the enclosing trace or the name of 
+  // the module group
+  std::string nextGroup;
+  
+  // The traceIDs of the traceStreams that are currently entered on the outgoing stream, innermost last
+  std::list<int> openTraces;
+  
+  // Boxplot and heatmap traces show only the distribution of their observations. Rather than emitting the
+  // observations of all the incoming streams, TraceObsMerger adds them to these mergeable sketches and
+  // TraceStreamMerger emits the sketches as traceSketch tags when the traceStream exits.
+  // Each map is keyed by the traceID, then the context (the names and values of the context attributes) 
+  // and then the name of the trace attribute.
+  std::map<int, std::map<std::map<std::string, std::string>, std::map<std::string, common::quantileSketch> > > quantiles;
+  std::map<int, std::map<std::map<std::string, std::string>, std::map<std::string, common::histogramSketch> > > histograms;
+  // The outgoing anchorID of the most recent observation of each trace attribute in each context
+  std::map<int, std::map<std::map<std::string, std::string>, std::map<std::string, int> > > anchorIDs;
+  
   // Maps the TraceIDs within an incoming stream to the TraceIDs on its corresponding outgoing stream
   //std::map<streamID, streamID> in2outTraceIDs;
   
@@ -658,6 +788,9 @@ class TraceStreamRecord: public streamRecord {
   TraceStreamRecord(const variantID& vID) : streamRecord(vID, "traceStream") { /*maxTraceID=0;*/ }
   TraceStreamRecord(const TraceStreamRecord& that, int vSuffixID);
   
+  // Sets the group under which the observations of the next traceStream are recorded in the trace store
+  void setNextGroup(const std::string& g) { nextGroup = g; }
+  
   // Returns a dynamically-allocated copy of this streamRecord, specialized to the given variant ID,
   // which is appended to the new stream's variant list.
   streamRecord* copy(int vSuffixID);
@@ -666,6 +799,13 @@ class TraceStreamRecord: public streamRecord {
   // to contain the state that succeeds them all, making it possible to resume processing
   void resumeFrom(std::vector<std::map<std::string, streamRecord*> >& streams);
   
+  // Adds the observation in the given traceObs tag, read from the incoming stream with the given records,
+  // to the sketches of the given trace on the outgoing stream
+  void addToSketches(int traceID, properties::iterator obsTag, std::map<std::string, streamRecord*>& inStreamRecords);
+  
+  // Appends to tags a traceSketch tag for each context of the given trace and discards the trace's sketches
+  void emitSketches(int traceID, std::list<std::pair<properties::tagType, properties> >& tags);
+  
   // Marge the IDs of the next graph (stored in tags) along all the incoming streams into a single ID in the outgoing stream,
   // updating each incoming stream's mappings from its IDs to the outgoing stream's IDs. Returns the traceID of the merged trace
   // in the outgoing stream.